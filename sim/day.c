@@ -0,0 +1,488 @@
+#include <stdlib.h>
+
+#include "sim.h"
+#include "message_keys.auto.h"
+#include "sim_app_limits.auto.h"
+
+#undef time
+
+int happymac_main(void);
+
+/* Monday 2026-01-05 00:00:00 UTC. */
+#define DAY_START ((time_t)1767571200)
+#define DAY_SECONDS (24 * 60 * 60)
+#define AT(h, m) ((h) * 60 + (m))
+
+/* Must match SETTINGS_HASH_VERSION and settings_hash() in HappyMac.c and
+ * settingsHash() in index.js. The replay exits if the watch's first hash
+ * differs from phone_settings_hash() of the defaults. */
+#define SETTINGS_HASH_VERSION 2
+#define WEATHER_REPLY_DELAY 3
+#define WEATHER_LATE_DELAY (8 * 60)
+#define INBOX_QUEUE_SIZE 16
+#define INBOX_MESSAGE_SIZE 128
+
+/* Phone side: what Clay has stored, mirroring settingsHash() in index.js. */
+typedef struct PhoneSettings {
+  int theme;
+  bool weather_enabled;
+  bool weather_show_temp;
+  bool unit_f;
+  bool seconds_enabled;
+  int seconds_timeout;
+} PhoneSettings;
+
+static const PhoneSettings s_phone_defaults = {
+  .theme = 0,
+  .weather_enabled = true,
+  .weather_show_temp = true,
+  .unit_f = false,
+  .seconds_enabled = false,
+  .seconds_timeout = 5,
+};
+
+static PhoneSettings s_phone;
+
+static const PhoneSettings s_presets[] = {
+  { .theme = 1, .weather_enabled = true, .weather_show_temp = true,
+    .seconds_enabled = true, .seconds_timeout = 5 },
+  { .theme = 2, .weather_enabled = true, .weather_show_temp = true,
+    .seconds_enabled = true, .seconds_timeout = 1 },
+  { .theme = 0, .weather_enabled = true, .weather_show_temp = true, .unit_f = true,
+    .seconds_enabled = false, .seconds_timeout = 5 },
+  /* Submitted while disconnected; the watch's settings win on reconnect. */
+  { .theme = 1, .weather_enabled = false, .weather_show_temp = true,
+    .seconds_enabled = false, .seconds_timeout = 15 },
+};
+
+typedef enum {
+  EVENT_BATTERY,
+  EVENT_LINK_LOST,
+  EVENT_BT_DOWN,
+  EVENT_BT_UP,
+  EVENT_CONFIG_OPEN,
+  EVENT_CONFIG_SUBMIT,
+} EventType;
+
+typedef struct DayEvent {
+  int minute;
+  EventType type;
+  int arg;
+  bool charging;
+} DayEvent;
+
+static const DayEvent s_events[] = {
+  { AT(2, 0), EVENT_BATTERY, 90, false },
+  /* Drops two minutes before the late reply to the 02:42 request lands. */
+  { AT(2, 48), EVENT_BT_DOWN, 0, false },
+  { AT(3, 20), EVENT_CONFIG_SUBMIT, 3, false },
+  { AT(3, 45), EVENT_BT_UP, 0, false },
+  { AT(5, 0), EVENT_BATTERY, 80, false },
+  { AT(8, 0), EVENT_BATTERY, 70, false },
+  { AT(8, 0), EVENT_CONFIG_OPEN, 0, false },
+  { AT(8, 1), EVENT_CONFIG_SUBMIT, 0, false },
+  { AT(10, 30), EVENT_BATTERY, 60, false },
+  { AT(12, 30), EVENT_CONFIG_OPEN, 0, false },
+  { AT(12, 31), EVENT_CONFIG_SUBMIT, 1, false },
+  { AT(13, 0), EVENT_BATTERY, 50, false },
+  { AT(13, 10), EVENT_BT_DOWN, 0, false },
+  { AT(13, 40), EVENT_BT_UP, 0, false },
+  { AT(15, 30), EVENT_BATTERY, 40, false },
+  /* The link dies before the app is told, so the 16:53 weather request
+   * fails to send. */
+  { AT(16, 50), EVENT_LINK_LOST, 0, false },
+  { AT(16, 55), EVENT_BT_DOWN, 0, false },
+  { AT(17, 0), EVENT_BT_UP, 0, false },
+  { AT(18, 0), EVENT_BATTERY, 30, false },
+  { AT(19, 0), EVENT_BT_DOWN, 0, false },
+  { AT(19, 5), EVENT_BT_UP, 0, false },
+  { AT(19, 30), EVENT_BATTERY, 20, false },
+  { AT(21, 0), EVENT_CONFIG_OPEN, 0, false },
+  { AT(21, 1), EVENT_CONFIG_SUBMIT, 2, false },
+  { AT(22, 0), EVENT_BATTERY, 20, true },
+  { AT(23, 0), EVENT_BATTERY, 30, true },
+};
+
+/* Wrist taps between 07:00 and 23:00. */
+#define TAP_FIRST AT(7, 0)
+#define TAP_LAST AT(23, 0)
+#define TAP_EVERY 20
+
+typedef struct PendingInbox {
+  time_t due;
+  size_t size;
+  uint8_t data[INBOX_MESSAGE_SIZE];
+} PendingInbox;
+
+static PendingInbox s_inbox_queue[INBOX_QUEUE_SIZE];
+static int s_inbox_count;
+static time_t s_now;
+
+/* Cost of the ticks that only change the seconds readout. Such a tick may
+ * invalidate no more than the readout itself; the replay exits otherwise. */
+#define SECOND_TICK_DIRTY_LIMIT (SIM_SECONDS_WIDTH * SIM_SECONDS_HEIGHT)
+
+static struct {
+  uint32_t frames;
+  uint32_t draw_calls;
+  uint64_t dirty_pixels;
+  uint64_t max_dirty_pixels;
+} s_second_ticks;
+
+static struct {
+  uint32_t requests;
+  uint32_t replies_queued;
+  uint32_t replies_lost;
+  uint32_t replies_delayed;
+} s_weather;
+
+static struct {
+  uint32_t hash_only_received;
+  uint32_t full_received;
+  uint32_t requests_sent;
+  uint32_t config_pushes;
+  uint32_t hash_mismatches;
+  uint32_t last_watch_hash;
+  bool first_hash_checked;
+} s_settings;
+
+static uint32_t phone_settings_hash(const PhoneSettings *settings) {
+  return ((uint32_t)(settings->theme & 0xFF)) |
+         ((uint32_t)(settings->weather_enabled ? 1 : 0) << 8) |
+         ((uint32_t)(settings->weather_show_temp ? 1 : 0) << 9) |
+         ((uint32_t)(settings->unit_f ? 1 : 0) << 10) |
+         ((uint32_t)(settings->seconds_enabled ? 1 : 0) << 11) |
+         ((uint32_t)SETTINGS_HASH_VERSION << 16) |
+         ((uint32_t)(settings->seconds_timeout & 0x3F) << 24);
+}
+
+/* Queues a phone-to-watch message `delay` seconds from now. Only one may be
+ * under construction at a time. */
+static DictionaryIterator *queue_inbox(int delay) {
+  if (s_inbox_count >= INBOX_QUEUE_SIZE) {
+    fprintf(stderr, "sim: inbox queue full\n");
+    exit(1);
+  }
+  PendingInbox *pending = &s_inbox_queue[s_inbox_count++];
+  pending->due = s_now + delay;
+  static DictionaryIterator iter;
+  sim_dict_init(&iter, pending->data, sizeof(pending->data));
+  return &iter;
+}
+
+static void finish_inbox(DictionaryIterator *iter) {
+  s_inbox_queue[s_inbox_count - 1].size = sim_dict_size(iter);
+}
+
+static void deliver_due_inbox(void) {
+  int i = 0;
+  while (i < s_inbox_count) {
+    if (s_inbox_queue[i].due > s_now) {
+      ++i;
+      continue;
+    }
+    PendingInbox pending = s_inbox_queue[i];
+    memmove(&s_inbox_queue[i], &s_inbox_queue[i + 1],
+            (s_inbox_count - i - 1) * sizeof(PendingInbox));
+    --s_inbox_count;
+    sim_deliver_inbox(pending.data, pending.size);
+  }
+}
+
+static int32_t tuple_int(const Tuple *tuple) {
+  switch (tuple->length) {
+    case 1:
+      return tuple->type == TUPLE_INT ? tuple->value->int8 : tuple->value->uint8;
+    case 2:
+      return tuple->type == TUPLE_INT ? tuple->value->int16 : tuple->value->uint16;
+    default:
+      return tuple->value->int32;
+  }
+}
+
+/* The phone's side of every message the watch sends. */
+static void phone_receive(const DictionaryIterator *iter) {
+  Tuple *theme = dict_find(iter, MESSAGE_KEY_theme);
+  if (theme) {
+    Tuple *hash = dict_find(iter, MESSAGE_KEY_SETTINGS_HASH);
+    if (hash) {
+      s_settings.last_watch_hash = (uint32_t)tuple_int(hash);
+    }
+    s_settings.full_received++;
+    s_phone.theme = tuple_int(theme);
+    Tuple *tuple = dict_find(iter, MESSAGE_KEY_WEATHER_ENABLED);
+    s_phone.weather_enabled = tuple ? tuple_int(tuple) != 0 : s_phone.weather_enabled;
+    tuple = dict_find(iter, MESSAGE_KEY_WEATHER_SHOW_TEMP);
+    s_phone.weather_show_temp = tuple ? tuple_int(tuple) != 0 : s_phone.weather_show_temp;
+    tuple = dict_find(iter, MESSAGE_KEY_WEATHER_TEMP_UNIT);
+    s_phone.unit_f = tuple ? tuple_int(tuple) == 1 : s_phone.unit_f;
+    tuple = dict_find(iter, MESSAGE_KEY_SECONDS_ENABLED);
+    s_phone.seconds_enabled = tuple ? tuple_int(tuple) != 0 : s_phone.seconds_enabled;
+    tuple = dict_find(iter, MESSAGE_KEY_SECONDS_TIMEOUT);
+    s_phone.seconds_timeout = tuple ? tuple_int(tuple) : s_phone.seconds_timeout;
+  } else {
+    Tuple *hash = dict_find(iter, MESSAGE_KEY_SETTINGS_HASH);
+    if (hash) {
+      s_settings.last_watch_hash = (uint32_t)tuple_int(hash);
+      s_settings.hash_only_received++;
+      if (!s_settings.first_hash_checked) {
+        /* Both sides start from defaults, so a mismatch here means the bit
+         * layout in this file has drifted from HappyMac.c. */
+        s_settings.first_hash_checked = true;
+        const uint32_t expected = phone_settings_hash(&s_phone_defaults);
+        if (s_settings.last_watch_hash != expected) {
+          fprintf(stderr, "sim: watch hash 0x%08x != phone_settings_hash 0x%08x\n",
+                  s_settings.last_watch_hash, expected);
+          exit(1);
+        }
+      }
+      if ((uint32_t)tuple_int(hash) != phone_settings_hash(&s_phone)) {
+        s_settings.hash_mismatches++;
+        s_settings.requests_sent++;
+        DictionaryIterator *out = queue_inbox(1);
+        dict_write_uint8(out, MESSAGE_KEY_SETTINGS_REQUEST, 1);
+        finish_inbox(out);
+      }
+    }
+  }
+
+  if (dict_find(iter, MESSAGE_KEY_WEATHER_REQUEST)) {
+    const uint32_t request = ++s_weather.requests;
+    if (request % 5 == 0) {
+      s_weather.replies_lost++;
+      return;
+    }
+    const bool late = request % 4 == 0;
+    if (late) {
+      s_weather.replies_delayed++;
+    }
+    s_weather.replies_queued++;
+    const int hour = (int)((s_now - DAY_START) / 3600) % 24;
+    const int32_t temp_c = 2 + (hour > 14 ? 28 - hour : hour) / 2;
+    const int32_t temp = s_phone.unit_f ? temp_c * 9 / 5 + 32 : temp_c;
+    static const int32_t codes[] = { 0, 2, 3, 45, 61, 71, 95 };
+    const int32_t code = codes[hour % (int)(sizeof(codes) / sizeof(codes[0]))];
+    DictionaryIterator *out = queue_inbox(late ? WEATHER_LATE_DELAY : WEATHER_REPLY_DELAY);
+    dict_write_int(out, MESSAGE_KEY_WEATHER_TEMP, &temp, sizeof(temp), true);
+    dict_write_int(out, MESSAGE_KEY_WEATHER_CODE, &code, sizeof(code), true);
+    finish_inbox(out);
+  }
+}
+
+/* Clay sends selects as strings and toggles as integers. */
+static void phone_submit_config(const PhoneSettings *preset) {
+  s_phone = *preset;
+  s_settings.config_pushes++;
+  char theme[4];
+  char timeout[4];
+  snprintf(theme, sizeof(theme), "%d", preset->theme);
+  snprintf(timeout, sizeof(timeout), "%d", preset->seconds_timeout);
+  const int32_t weather_enabled = preset->weather_enabled;
+  const int32_t show_temp = preset->weather_show_temp;
+  const int32_t seconds_enabled = preset->seconds_enabled;
+
+  DictionaryIterator *out = queue_inbox(0);
+  dict_write_cstring(out, MESSAGE_KEY_theme, theme);
+  dict_write_int(out, MESSAGE_KEY_WEATHER_ENABLED, &weather_enabled, sizeof(int32_t), true);
+  dict_write_int(out, MESSAGE_KEY_WEATHER_SHOW_TEMP, &show_temp, sizeof(int32_t), true);
+  dict_write_cstring(out, MESSAGE_KEY_WEATHER_TEMP_UNIT, preset->unit_f ? "F" : "C");
+  dict_write_int(out, MESSAGE_KEY_SECONDS_ENABLED, &seconds_enabled, sizeof(int32_t), true);
+  dict_write_cstring(out, MESSAGE_KEY_SECONDS_TIMEOUT, timeout);
+  finish_inbox(out);
+}
+
+static void phone_open_config(void) {
+  const uint32_t hash = phone_settings_hash(&s_phone);
+  DictionaryIterator *out = queue_inbox(0);
+  dict_write_uint32(out, MESSAGE_KEY_SETTINGS_HASH, hash);
+  finish_inbox(out);
+}
+
+static void run_event(const DayEvent *event) {
+  switch (event->type) {
+    case EVENT_BATTERY:
+      sim_set_battery((BatteryChargeState){
+        .charge_percent = event->arg,
+        .is_charging = event->charging,
+        .is_plugged = event->charging,
+      });
+      break;
+    case EVENT_LINK_LOST:
+      sim_set_bluetooth(false, false);
+      break;
+    case EVENT_BT_DOWN:
+      sim_set_bluetooth(false, true);
+      break;
+    case EVENT_BT_UP:
+      sim_set_bluetooth(true, true);
+      break;
+    case EVENT_CONFIG_OPEN:
+      phone_open_config();
+      break;
+    case EVENT_CONFIG_SUBMIT:
+      phone_submit_config(&s_presets[event->arg]);
+      break;
+  }
+}
+
+static void settle(void) {
+  sim_flush_outbox(phone_receive);
+  sim_render_if_dirty();
+}
+
+void sim_replay(void) {
+  s_now = DAY_START;
+  s_phone = s_phone_defaults;
+  settle();
+
+  size_t next_event = 0;
+  for (int second = 1; second <= DAY_SECONDS; ++second) {
+    s_now = DAY_START + second;
+    sim_set_time(s_now);
+
+    TimeUnits units = SECOND_UNIT;
+    if (second % 60 == 0) {
+      units |= MINUTE_UNIT;
+      const int minute = second / 60;
+      while (next_event < sizeof(s_events) / sizeof(s_events[0]) &&
+             s_events[next_event].minute <= minute) {
+        run_event(&s_events[next_event++]);
+        settle();
+      }
+      if (minute >= TAP_FIRST && minute <= TAP_LAST && minute % TAP_EVERY == 0) {
+        sim_tap();
+        settle();
+      }
+    }
+    if (second % 3600 == 0) {
+      units |= HOUR_UNIT;
+    }
+    if (second % DAY_SECONDS == 0) {
+      units |= DAY_UNIT;
+    }
+
+    deliver_due_inbox();
+    settle();
+    const uint32_t frames = g_sim_stats.frames_rendered;
+    const uint32_t draw_calls = g_sim_stats.draw_calls;
+    const uint64_t dirty_pixels = g_sim_stats.dirty_pixels;
+    sim_tick(units);
+    settle();
+    if (units == SECOND_UNIT) {
+      const uint64_t tick_dirty = g_sim_stats.dirty_pixels - dirty_pixels;
+      if (tick_dirty > SECOND_TICK_DIRTY_LIMIT) {
+        fprintf(stderr, "sim: seconds tick at %02d:%02d:%02d dirtied %llu px, limit %d\n",
+                second / 3600, second / 60 % 60, second % 60,
+                (unsigned long long)tick_dirty, SECOND_TICK_DIRTY_LIMIT);
+        exit(1);
+      }
+      s_second_ticks.frames += g_sim_stats.frames_rendered - frames;
+      s_second_ticks.draw_calls += g_sim_stats.draw_calls - draw_calls;
+      s_second_ticks.dirty_pixels += tick_dirty;
+      if (tick_dirty > s_second_ticks.max_dirty_pixels) {
+        s_second_ticks.max_dirty_pixels = tick_dirty;
+      }
+    }
+  }
+}
+
+static void write_report(FILE *out) {
+  const SimStats *s = &g_sim_stats;
+  fprintf(out, "{\n");
+  fprintf(out, "  \"platform\": \"%s\",\n", g_sim_platform->name);
+  fprintf(out, "  \"simulated_seconds\": %d,\n", DAY_SECONDS);
+  fprintf(out, "  \"app_messages\": {\n");
+  fprintf(out, "    \"sent\": %u,\n", s->messages_sent);
+  fprintf(out, "    \"send_failed\": %u,\n", s->messages_send_failed);
+  fprintf(out, "    \"outbox_busy\": %u,\n", s->messages_outbox_busy);
+  fprintf(out, "    \"dict_overflow\": %u,\n", s->messages_dict_overflow);
+  fprintf(out, "    \"received\": %u,\n", s->messages_received);
+  fprintf(out, "    \"dropped\": %u,\n", s->messages_dropped);
+  fprintf(out, "    \"bytes_sent\": %u,\n", s->bytes_sent);
+  fprintf(out, "    \"bytes_received\": %u\n", s->bytes_received);
+  fprintf(out, "  },\n");
+  fprintf(out, "  \"weather\": {\n");
+  fprintf(out, "    \"requests\": %u,\n", s_weather.requests);
+  fprintf(out, "    \"replies\": %u,\n", s_weather.replies_queued);
+  fprintf(out, "    \"replies_lost\": %u,\n", s_weather.replies_lost);
+  fprintf(out, "    \"replies_delayed\": %u\n", s_weather.replies_delayed);
+  fprintf(out, "  },\n");
+  fprintf(out, "  \"settings\": {\n");
+  fprintf(out, "    \"config_pushes\": %u,\n", s_settings.config_pushes);
+  fprintf(out, "    \"hash_only_from_watch\": %u,\n", s_settings.hash_only_received);
+  fprintf(out, "    \"full_from_watch\": %u,\n", s_settings.full_received);
+  fprintf(out, "    \"hash_mismatches\": %u,\n", s_settings.hash_mismatches);
+  fprintf(out, "    \"requests_to_watch\": %u,\n", s_settings.requests_sent);
+  fprintf(out, "    \"in_sync\": %s\n",
+          s_settings.last_watch_hash == phone_settings_hash(&s_phone) ? "true" : "false");
+  fprintf(out, "  },\n");
+  fprintf(out, "  \"persist\": {\n");
+  fprintf(out, "    \"writes\": %u,\n", s->persist_writes);
+  fprintf(out, "    \"bytes\": %u\n", s->persist_bytes);
+  fprintf(out, "  },\n");
+  fprintf(out, "  \"gbitmap\": {\n");
+  fprintf(out, "    \"created\": %u,\n", s->gbitmaps_created);
+  fprintf(out, "    \"sub_bitmaps_created\": %u,\n", s->gbitmap_subs_created);
+  fprintf(out, "    \"destroyed\": %u\n", s->gbitmaps_destroyed);
+  fprintf(out, "  },\n");
+  fprintf(out, "  \"layers\": {\n");
+  fprintf(out, "    \"invalidations\": %u,\n", s->layer_invalidations);
+  fprintf(out, "    \"dirty_pixels\": %llu\n", (unsigned long long)s->dirty_pixels);
+  fprintf(out, "  },\n");
+  /* The firmware re-renders the whole window for any dirty layer. */
+  const uint64_t screen_pixels =
+      (uint64_t)g_sim_platform->screen.w * (uint64_t)g_sim_platform->screen.h;
+  fprintf(out, "  \"frames\": {\n");
+  fprintf(out, "    \"rendered\": %u,\n", s->frames_rendered);
+  fprintf(out, "    \"draw_calls\": %u,\n", s->draw_calls);
+  fprintf(out, "    \"repainted_pixels\": %llu\n",
+          (unsigned long long)(s->frames_rendered * screen_pixels));
+  fprintf(out, "  },\n");
+  fprintf(out, "  \"second_ticks\": {\n");
+  fprintf(out, "    \"frames\": %u,\n", s_second_ticks.frames);
+  fprintf(out, "    \"draw_calls\": %u,\n", s_second_ticks.draw_calls);
+  fprintf(out, "    \"dirty_pixels\": %llu,\n",
+          (unsigned long long)s_second_ticks.dirty_pixels);
+  fprintf(out, "    \"max_dirty_pixels_per_tick\": %llu,\n",
+          (unsigned long long)s_second_ticks.max_dirty_pixels);
+  fprintf(out, "    \"dirty_pixel_limit\": %d,\n", SECOND_TICK_DIRTY_LIMIT);
+  fprintf(out, "    \"repainted_pixels\": %llu\n",
+          (unsigned long long)(s_second_ticks.frames * screen_pixels));
+  fprintf(out, "  },\n");
+  fprintf(out, "  \"ticks\": {\n");
+  fprintf(out, "    \"second\": %u,\n", s->ticks_second);
+  fprintf(out, "    \"minute\": %u,\n", s->ticks_minute);
+  fprintf(out, "    \"tap_wakeups\": %u\n", s->tap_wakeups);
+  fprintf(out, "  }\n");
+  fprintf(out, "}\n");
+}
+
+int main(int argc, char **argv) {
+  setenv("TZ", "UTC", 1);
+  tzset();
+
+  g_sim_platform = sim_find_platform(SIM_PLATFORM);
+  if (!g_sim_platform) {
+    fprintf(stderr, "sim: unknown platform %s\n", SIM_PLATFORM);
+    return 1;
+  }
+  sim_set_time(DAY_START);
+  sim_set_battery((BatteryChargeState){ .charge_percent = 100 });
+  sim_set_bluetooth(true, true);
+
+  happymac_main();
+
+  FILE *out = stdout;
+  if (argc > 1) {
+    out = fopen(argv[1], "w");
+    if (!out) {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+  write_report(out);
+  if (out != stdout) {
+    fclose(out);
+  }
+  return 0;
+}
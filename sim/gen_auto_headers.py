@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+"""Generate the SDK's *.auto.h headers from package.json for the simulator.
+
+Usage: gen_auto_headers.py <package.json> <output dir>
+"""
+
+import json
+import os
+import re
+import struct
+import sys
+
+
+def png_size(path):
+    with open(path, "rb") as png:
+        header = png.read(24)
+    if header[:8] != b"\x89PNG\r\n\x1a\n" or header[12:16] != b"IHDR":
+        raise SystemExit("%s: not a PNG" % path)
+    return struct.unpack(">II", header[16:24])
+
+
+def app_define(source, name):
+    match = re.search(r"^#define %s (\d+)$" % name, source, re.MULTILINE)
+    if not match:
+        raise SystemExit("HappyMac.c: #define %s not found" % name)
+    return int(match.group(1))
+
+
+def main():
+    package_path, out_dir = sys.argv[1], sys.argv[2]
+    with open(package_path) as f:
+        pebble = json.load(f)["pebble"]
+    project_dir = os.path.dirname(os.path.abspath(package_path))
+    resources_dir = os.path.join(project_dir, "resources")
+    os.makedirs(out_dir, exist_ok=True)
+
+    # Message keys are numbered from 10000 in declaration order.
+    with open(os.path.join(out_dir, "message_keys.auto.h"), "w") as out:
+        out.write("#pragma once\n\n")
+        for i, name in enumerate(pebble["messageKeys"]):
+            out.write("#define MESSAGE_KEY_%s %d\n" % (name, 10000 + i))
+
+    media = pebble["resources"]["media"]
+    with open(os.path.join(out_dir, "resource_ids.auto.h"), "w") as out:
+        out.write("#pragma once\n\n")
+        for i, entry in enumerate(media):
+            out.write("#define RESOURCE_ID_%s %d\n" % (entry["name"], i + 1))
+
+    with open(os.path.join(out_dir, "sim_resources.auto.h"), "w") as out:
+        out.write("#pragma once\n\n")
+        out.write("static const struct {\n  uint32_t id;\n  GSize size;\n} s_sim_image_resources[] = {\n")
+        for i, entry in enumerate(media):
+            if entry["type"] not in ("png", "bitmap"):
+                continue
+            w, h = png_size(os.path.join(resources_dir, entry["file"]))
+            out.write("  { %d, { %d, %d } },\n" % (i + 1, w, h))
+        out.write("};\n")
+
+    # Limits the replay enforces, read from the app so they cannot go stale.
+    with open(os.path.join(project_dir, "src", "c", "HappyMac.c")) as f:
+        app_source = f.read()
+    with open(os.path.join(out_dir, "sim_app_limits.auto.h"), "w") as out:
+        out.write("#pragma once\n\n")
+        for name in ("SECONDS_WIDTH", "SECONDS_HEIGHT"):
+            out.write("#define SIM_%s %d\n" % (name, app_define(app_source, name)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,56 @@
+/* Renders the sprite for every theme into a framebuffer pre-filled with a
+ * pattern and writes the raw bytes to argv[1]. Built once with the
+ * framebuffer renderer and once with MATRIX_FRAMEBUFFER_RENDERER=0; `make
+ * check` requires the two dumps to be identical. */
+
+#define main happymac_main
+#include "../src/c/HappyMac.c"
+#undef main
+
+#include "sim.h"
+
+void sim_replay(void) {
+}
+
+int main(int argc, char **argv) {
+  g_sim_platform = sim_find_platform(SIM_PLATFORM);
+  if (!g_sim_platform || argc < 2) {
+    fprintf(stderr, "usage: %s <dump file>\n", argv[0]);
+    return 1;
+  }
+  FILE *out = fopen(argv[1], "wb");
+  if (!out) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  s_window = window_create();
+  Layer *matrix_layer = layer_create(layer_get_bounds(window_get_root_layer(s_window)));
+  layer_set_update_proc(matrix_layer, matrix_layer_update_proc);
+
+  static const char *const theme_names[] = { "light", "dark", "color" };
+  for (int theme = THEME_LIGHT; theme <= THEME_COLOR; ++theme) {
+    s_theme = theme;
+    apply_theme();
+
+    GBitmap *frame_buffer = graphics_capture_frame_buffer(NULL);
+    uint8_t *data = gbitmap_get_data(frame_buffer);
+    const size_t size =
+        (size_t)gbitmap_get_bytes_per_row(frame_buffer) * gbitmap_get_bounds(frame_buffer).size.h;
+    /* A pattern instead of a flat fill catches writes outside the sprite
+     * cells, including stray bits in partially covered 1-bit bytes. */
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = (uint8_t)(i * 37 + theme);
+    }
+
+    const uint32_t draw_calls = g_sim_stats.draw_calls;
+    sim_render_layer(matrix_layer);
+    fwrite(data, 1, size, out);
+    printf("%s %s: %u fill calls\n", SIM_PLATFORM, theme_names[theme],
+           g_sim_stats.draw_calls - draw_calls);
+  }
+
+  layer_destroy(matrix_layer);
+  fclose(out);
+  return 0;
+}
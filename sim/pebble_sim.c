@@ -0,0 +1,834 @@
+#include <stdlib.h>
+
+#include "sim.h"
+#include "sim_resources.auto.h"
+
+#undef time
+
+SimStats g_sim_stats;
+const SimPlatform *g_sim_platform;
+
+static const SimPlatform s_platforms[] = {
+  { "aplite", { 144, 168 }, GBitmapFormat1Bit, GBitmapFormat1Bit },
+  { "basalt", { 144, 168 }, GBitmapFormat8Bit, GBitmapFormat2BitPalette },
+  { "chalk", { 180, 180 }, GBitmapFormat8BitCircular, GBitmapFormat2BitPalette },
+  { "diorite", { 144, 168 }, GBitmapFormat1Bit, GBitmapFormat2BitPalette },
+  { "emery", { 200, 228 }, GBitmapFormat8Bit, GBitmapFormat2BitPalette },
+  { "flint", { 144, 168 }, GBitmapFormat1Bit, GBitmapFormat2BitPalette },
+};
+
+struct Layer {
+  GRect frame;
+  LayerUpdateProc update_proc;
+  bool hidden;
+  Layer *parent;
+  Layer *first_child;
+  Layer *next_sibling;
+};
+
+struct TextLayer {
+  Layer layer;
+  const char *text;
+};
+
+struct Window {
+  Layer root_layer;
+  WindowHandlers handlers;
+  bool loaded;
+};
+
+struct GBitmap {
+  GRect bounds;
+  GBitmapFormat format;
+  uint16_t bytes_per_row;
+  uint8_t *data;
+  GColor *palette;
+  bool owns_memory;
+};
+
+struct GContext {
+  GColor fill_color;
+  GColor text_color;
+  GCompOp compositing_mode;
+  /* Screen position of the layer being drawn, and its visible part. */
+  GPoint offset;
+  GRect clip;
+};
+
+static time_t s_now;
+static bool s_dirty;
+static Window *s_top_window;
+static GBitmap *s_frame_buffer;
+
+static TimeUnits s_tick_units;
+static TickHandler s_tick_handler;
+static BatteryChargeState s_battery_state = { .charge_percent = 100 };
+static BatteryStateHandler s_battery_handler;
+static bool s_bt_connected = true;
+/* What the app was last told; lags s_bt_connected until a notify. */
+static bool s_bt_notified = true;
+static BluetoothConnectionHandler s_bt_handler;
+static AccelTapHandler s_tap_handler;
+
+static uint32_t s_inbox_size;
+static uint32_t s_outbox_size;
+static uint8_t *s_outbox_buffer;
+static DictionaryIterator s_outbox_iter;
+static bool s_outbox_open;
+static bool s_outbox_pending;
+static AppMessageInboxReceived s_inbox_handler;
+
+#define SIM_PERSIST_SLOTS 32
+
+static struct {
+  bool used;
+  uint32_t key;
+  int32_t value;
+} s_persist[SIM_PERSIST_SLOTS];
+
+static void prv_invalidate(GRect frame) {
+  g_sim_stats.layer_invalidations++;
+  g_sim_stats.dirty_pixels += (uint64_t)frame.size.w * (uint64_t)frame.size.h;
+  s_dirty = true;
+}
+
+static bool prv_rect_equal(GRect a, GRect b) {
+  return a.origin.x == b.origin.x && a.origin.y == b.origin.y &&
+         a.size.w == b.size.w && a.size.h == b.size.h;
+}
+
+/* Clock and services */
+
+time_t sim_time(time_t *tloc) {
+  if (tloc) {
+    *tloc = s_now;
+  }
+  return s_now;
+}
+
+void sim_set_time(time_t now) {
+  s_now = now;
+}
+
+void sim_set_bluetooth(bool connected, bool notify) {
+  s_bt_connected = connected;
+  if (notify && connected != s_bt_notified) {
+    s_bt_notified = connected;
+    if (s_bt_handler) {
+      s_bt_handler(connected);
+    }
+  }
+}
+
+void sim_set_battery(BatteryChargeState state) {
+  s_battery_state = state;
+  if (s_battery_handler) {
+    s_battery_handler(state);
+  }
+}
+
+void sim_tap(void) {
+  if (s_tap_handler) {
+    g_sim_stats.tap_wakeups++;
+    s_tap_handler(ACCEL_AXIS_Z, 1);
+  }
+}
+
+void sim_tick(TimeUnits units_changed) {
+  if (!s_tick_handler || !(units_changed & s_tick_units)) {
+    return;
+  }
+  /* Count what fired, not what is subscribed: a minute boundary seen by a
+   * SECOND_UNIT subscriber is still a minute tick. */
+  if (units_changed & MINUTE_UNIT) {
+    g_sim_stats.ticks_minute++;
+  } else {
+    g_sim_stats.ticks_second++;
+  }
+  struct tm tick_time = *localtime(&s_now);
+  s_tick_handler(&tick_time, units_changed);
+}
+
+TimeUnits sim_tick_units(void) {
+  return s_tick_units;
+}
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+  s_tick_units = tick_units;
+  s_tick_handler = handler;
+}
+
+void tick_timer_service_unsubscribe(void) {
+  s_tick_units = 0;
+  s_tick_handler = NULL;
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+  return s_battery_state;
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler) {
+  s_battery_handler = handler;
+}
+
+void battery_state_service_unsubscribe(void) {
+  s_battery_handler = NULL;
+}
+
+bool bluetooth_connection_service_peek(void) {
+  return s_bt_connected;
+}
+
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler) {
+  s_bt_handler = handler;
+}
+
+void bluetooth_connection_service_unsubscribe(void) {
+  s_bt_handler = NULL;
+}
+
+void accel_tap_service_subscribe(AccelTapHandler handler) {
+  s_tap_handler = handler;
+}
+
+void accel_tap_service_unsubscribe(void) {
+  s_tap_handler = NULL;
+}
+
+void app_event_loop(void) {
+  sim_replay();
+}
+
+/* Persistent storage */
+
+static int prv_persist_slot(uint32_t key, bool create) {
+  for (int i = 0; i < SIM_PERSIST_SLOTS; ++i) {
+    if (s_persist[i].used && s_persist[i].key == key) {
+      return i;
+    }
+  }
+  if (!create) {
+    return -1;
+  }
+  for (int i = 0; i < SIM_PERSIST_SLOTS; ++i) {
+    if (!s_persist[i].used) {
+      s_persist[i].used = true;
+      s_persist[i].key = key;
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool persist_exists(const uint32_t key) {
+  return prv_persist_slot(key, false) >= 0;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+  const int slot = prv_persist_slot(key, false);
+  return slot >= 0 ? s_persist[slot].value : 0;
+}
+
+bool persist_read_bool(const uint32_t key) {
+  return persist_read_int(key) != 0;
+}
+
+static int prv_persist_write(uint32_t key, int32_t value, int size) {
+  const int slot = prv_persist_slot(key, true);
+  if (slot < 0) {
+    return -1;
+  }
+  s_persist[slot].value = value;
+  g_sim_stats.persist_writes++;
+  g_sim_stats.persist_bytes += size;
+  return size;
+}
+
+int persist_write_int(const uint32_t key, const int32_t value) {
+  return prv_persist_write(key, value, sizeof(int32_t));
+}
+
+int persist_write_bool(const uint32_t key, const bool value) {
+  return prv_persist_write(key, value ? 1 : 0, sizeof(bool));
+}
+
+/* Dictionaries */
+
+void sim_dict_init(DictionaryIterator *iter, uint8_t *buffer, size_t size) {
+  iter->begin = buffer;
+  iter->end = buffer + size;
+  iter->cursor = buffer + 1;
+  buffer[0] = 0;
+}
+
+size_t sim_dict_size(const DictionaryIterator *iter) {
+  return (size_t)(iter->cursor - iter->begin);
+}
+
+static DictionaryResult prv_dict_write(DictionaryIterator *iter, uint32_t key, TupleType type,
+                                       const void *data, uint16_t length) {
+  if (!iter || !iter->begin) {
+    return DICT_INVALID_ARGS;
+  }
+  if (iter->cursor + sizeof(Tuple) + length > iter->end) {
+    g_sim_stats.messages_dict_overflow++;
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  Tuple *tuple = (Tuple *)iter->cursor;
+  tuple->key = key;
+  tuple->type = type;
+  tuple->length = length;
+  memcpy(tuple->value, data, length);
+  iter->cursor += sizeof(Tuple) + length;
+  iter->begin[0]++;
+  return DICT_OK;
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key) {
+  uint8_t *cursor = iter->begin + 1;
+  for (int i = 0; i < iter->begin[0]; ++i) {
+    Tuple *tuple = (Tuple *)cursor;
+    if (tuple->key == key) {
+      return tuple;
+    }
+    cursor += sizeof(Tuple) + tuple->length;
+  }
+  return NULL;
+}
+
+DictionaryResult dict_write_int(DictionaryIterator *iter, const uint32_t key,
+                                const void *integer, const uint8_t width_bytes,
+                                const bool is_signed) {
+  if (width_bytes != 1 && width_bytes != 2 && width_bytes != 4) {
+    return DICT_INVALID_ARGS;
+  }
+  return prv_dict_write(iter, key, is_signed ? TUPLE_INT : TUPLE_UINT, integer, width_bytes);
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key,
+                                  const uint8_t value) {
+  return prv_dict_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key,
+                                   const uint32_t value) {
+  return prv_dict_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key,
+                                    const char *cstring) {
+  return prv_dict_write(iter, key, TUPLE_CSTRING, cstring, strlen(cstring) + 1);
+}
+
+/* AppMessage */
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+  free(s_outbox_buffer);
+  s_inbox_size = size_inbound;
+  s_outbox_size = size_outbound;
+  s_outbox_buffer = malloc(size_outbound);
+  return s_outbox_buffer ? APP_MSG_OK : APP_MSG_INVALID_STATE;
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(
+    AppMessageInboxReceived received_callback) {
+  s_inbox_handler = received_callback;
+  return received_callback;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+  if (!s_outbox_buffer || s_outbox_open) {
+    return APP_MSG_INVALID_STATE;
+  }
+  if (s_outbox_pending) {
+    g_sim_stats.messages_outbox_busy++;
+    return APP_MSG_BUSY;
+  }
+  sim_dict_init(&s_outbox_iter, s_outbox_buffer, s_outbox_size);
+  s_outbox_open = true;
+  *iterator = &s_outbox_iter;
+  return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+  if (!s_outbox_open) {
+    return APP_MSG_INVALID_STATE;
+  }
+  s_outbox_open = false;
+  if (!s_bt_connected) {
+    g_sim_stats.messages_send_failed++;
+    return APP_MSG_NOT_CONNECTED;
+  }
+  g_sim_stats.messages_sent++;
+  g_sim_stats.bytes_sent += sim_dict_size(&s_outbox_iter);
+  s_outbox_pending = true;
+  return APP_MSG_OK;
+}
+
+void sim_flush_outbox(SimOutboxDelivery deliver) {
+  if (!s_outbox_pending) {
+    return;
+  }
+  s_outbox_pending = false;
+  deliver(&s_outbox_iter);
+}
+
+void sim_deliver_inbox(const uint8_t *dict, size_t size) {
+  if (!s_bt_connected || !s_inbox_handler || size > s_inbox_size) {
+    g_sim_stats.messages_dropped++;
+    return;
+  }
+  uint8_t *buffer = malloc(size);
+  memcpy(buffer, dict, size);
+  DictionaryIterator iter = { .begin = buffer, .end = buffer + size, .cursor = buffer + size };
+  g_sim_stats.messages_received++;
+  g_sim_stats.bytes_received += size;
+  s_inbox_handler(&iter, NULL);
+  free(buffer);
+}
+
+/* Layers and windows */
+
+Layer *layer_create(GRect frame) {
+  Layer *layer = calloc(1, sizeof(Layer));
+  layer->frame = frame;
+  return layer;
+}
+
+static void prv_layer_remove_from_parent(Layer *layer) {
+  if (!layer->parent) {
+    return;
+  }
+  Layer **link = &layer->parent->first_child;
+  while (*link && *link != layer) {
+    link = &(*link)->next_sibling;
+  }
+  if (*link) {
+    *link = layer->next_sibling;
+  }
+  layer->parent = NULL;
+  layer->next_sibling = NULL;
+}
+
+void layer_destroy(Layer *layer) {
+  if (!layer) {
+    return;
+  }
+  prv_layer_remove_from_parent(layer);
+  free(layer);
+}
+
+void layer_mark_dirty(Layer *layer) {
+  prv_invalidate(layer->frame);
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  prv_layer_remove_from_parent(child);
+  Layer **link = &parent->first_child;
+  while (*link) {
+    link = &(*link)->next_sibling;
+  }
+  *link = child;
+  child->parent = parent;
+  prv_invalidate(child->frame);
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  return GRect(0, 0, layer->frame.size.w, layer->frame.size.h);
+}
+
+GRect layer_get_frame(const Layer *layer) {
+  return layer->frame;
+}
+
+void layer_set_frame(Layer *layer, GRect frame) {
+  if (prv_rect_equal(frame, layer->frame)) {
+    return;
+  }
+  prv_invalidate(layer->frame);
+  layer->frame = frame;
+  prv_invalidate(frame);
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+  if (hidden == layer->hidden) {
+    return;
+  }
+  layer->hidden = hidden;
+  prv_invalidate(layer->frame);
+}
+
+bool layer_get_hidden(const Layer *layer) {
+  return layer->hidden;
+}
+
+static void prv_text_layer_update_proc(Layer *layer, GContext *ctx) {
+  const TextLayer *text_layer = (const TextLayer *)layer;
+  if (text_layer->text && text_layer->text[0] != '\0') {
+    g_sim_stats.draw_calls++;
+  }
+}
+
+TextLayer *text_layer_create(GRect frame) {
+  TextLayer *text_layer = calloc(1, sizeof(TextLayer));
+  text_layer->layer.frame = frame;
+  text_layer->layer.update_proc = prv_text_layer_update_proc;
+  return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+  if (!text_layer) {
+    return;
+  }
+  prv_layer_remove_from_parent(&text_layer->layer);
+  free(text_layer);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer) {
+  return &text_layer->layer;
+}
+
+/* Like the firmware, every setter invalidates the layer even when the value
+ * does not change. */
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+  text_layer->text = text;
+  layer_mark_dirty(&text_layer->layer);
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {
+  layer_mark_dirty(&text_layer->layer);
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {
+  layer_mark_dirty(&text_layer->layer);
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+  layer_mark_dirty(&text_layer->layer);
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment) {
+  layer_mark_dirty(&text_layer->layer);
+}
+
+Window *window_create(void) {
+  Window *window = calloc(1, sizeof(Window));
+  window->root_layer.frame = GRect(0, 0, g_sim_platform->screen.w, g_sim_platform->screen.h);
+  return window;
+}
+
+void window_destroy(Window *window) {
+  if (!window) {
+    return;
+  }
+  if (window->loaded && window->handlers.unload) {
+    window->handlers.unload(window);
+  }
+  if (s_top_window == window) {
+    s_top_window = NULL;
+  }
+  free(window);
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  window->handlers = handlers;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+  layer_mark_dirty(&window->root_layer);
+}
+
+Layer *window_get_root_layer(const Window *window) {
+  return (Layer *)&window->root_layer;
+}
+
+void window_stack_push(Window *window, bool animated) {
+  s_top_window = window;
+  if (!window->loaded && window->handlers.load) {
+    window->handlers.load(window);
+  }
+  window->loaded = true;
+  layer_mark_dirty(&window->root_layer);
+}
+
+static GRect prv_rect_intersect(GRect a, GRect b) {
+  const int x0 = a.origin.x > b.origin.x ? a.origin.x : b.origin.x;
+  const int y0 = a.origin.y > b.origin.y ? a.origin.y : b.origin.y;
+  const int ax1 = a.origin.x + a.size.w;
+  const int bx1 = b.origin.x + b.size.w;
+  const int ay1 = a.origin.y + a.size.h;
+  const int by1 = b.origin.y + b.size.h;
+  const int x1 = ax1 < bx1 ? ax1 : bx1;
+  const int y1 = ay1 < by1 ? ay1 : by1;
+  if (x1 <= x0 || y1 <= y0) {
+    return GRectZero;
+  }
+  return GRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+static void prv_render_layer(Layer *layer, GPoint parent_offset, GRect parent_clip) {
+  if (layer->hidden) {
+    return;
+  }
+  const GPoint offset = GPoint(parent_offset.x + layer->frame.origin.x,
+                               parent_offset.y + layer->frame.origin.y);
+  const GRect clip = prv_rect_intersect(
+      parent_clip, GRect(offset.x, offset.y, layer->frame.size.w, layer->frame.size.h));
+  if (layer->update_proc) {
+    GContext ctx = {
+      .fill_color = GColorBlack,
+      .text_color = GColorBlack,
+      .compositing_mode = GCompOpAssign,
+      .offset = offset,
+      .clip = clip,
+    };
+    layer->update_proc(layer, &ctx);
+  }
+  for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+    prv_render_layer(child, offset, clip);
+  }
+}
+
+void sim_render_layer(Layer *layer) {
+  const GRect screen = GRect(0, 0, g_sim_platform->screen.w, g_sim_platform->screen.h);
+  prv_render_layer(layer, GPoint(0, 0), screen);
+}
+
+void sim_render_if_dirty(void) {
+  if (!s_dirty || !s_top_window) {
+    return;
+  }
+  s_dirty = false;
+  g_sim_stats.frames_rendered++;
+  sim_render_layer(&s_top_window->root_layer);
+}
+
+/* Graphics */
+
+bool gcolor_equal(GColor8 x, GColor8 y) {
+  return x.argb == y.argb;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+  ctx->fill_color = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+  ctx->text_color = color;
+}
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) {
+  ctx->compositing_mode = mode;
+}
+
+/* B/W screens have no dithering here: a colour is white when its channels
+ * are bright on average, black otherwise. */
+static void prv_set_pixel(GBitmap *frame_buffer, int x, int y, GColor color) {
+  if (frame_buffer->format == GBitmapFormat1Bit) {
+    uint8_t *byte = frame_buffer->data + y * frame_buffer->bytes_per_row + (x >> 3);
+    if (color.r + color.g + color.b >= 5) {
+      *byte |= (uint8_t)(1 << (x & 7));
+    } else {
+      *byte &= (uint8_t)~(1 << (x & 7));
+    }
+    return;
+  }
+  const GBitmapDataRowInfo info = gbitmap_get_data_row_info(frame_buffer, y);
+  if (x >= info.min_x && x <= info.max_x) {
+    info.data[x] = color.argb;
+  }
+}
+
+/* Rounded corners are drawn square; the app only fills plain rects. */
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius,
+                        GCornerMask corner_mask) {
+  g_sim_stats.draw_calls++;
+  if (ctx->fill_color.a == 0) {
+    return;
+  }
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  const GRect area = prv_rect_intersect(
+      ctx->clip, GRect(ctx->offset.x + rect.origin.x, ctx->offset.y + rect.origin.y,
+                       rect.size.w, rect.size.h));
+  for (int y = area.origin.y; y < area.origin.y + area.size.h; ++y) {
+    for (int x = area.origin.x; x < area.origin.x + area.size.w; ++x) {
+      prv_set_pixel(frame_buffer, x, y, ctx->fill_color);
+    }
+  }
+}
+
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+  g_sim_stats.draw_calls++;
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box,
+                        GTextOverflowMode overflow_mode, GTextAlignment alignment,
+                        GTextAttributes *text_attributes) {
+  g_sim_stats.draw_calls++;
+}
+
+static uint16_t prv_bytes_per_row(GBitmapFormat format, int width) {
+  switch (format) {
+    case GBitmapFormat1Bit:
+      return ((width + 31) / 32) * 4;
+    case GBitmapFormat1BitPalette:
+      return (width + 7) / 8;
+    case GBitmapFormat2BitPalette:
+      return (width + 3) / 4;
+    case GBitmapFormat4BitPalette:
+      return (width + 1) / 2;
+    default:
+      return width;
+  }
+}
+
+static int prv_palette_size(GBitmapFormat format) {
+  switch (format) {
+    case GBitmapFormat1BitPalette:
+      return 2;
+    case GBitmapFormat2BitPalette:
+      return 4;
+    case GBitmapFormat4BitPalette:
+      return 16;
+    default:
+      return 0;
+  }
+}
+
+static GBitmap *prv_bitmap_create(GSize size, GBitmapFormat format) {
+  GBitmap *bitmap = calloc(1, sizeof(GBitmap));
+  bitmap->bounds = GRect(0, 0, size.w, size.h);
+  bitmap->format = format;
+  bitmap->bytes_per_row = prv_bytes_per_row(format, size.w);
+  bitmap->data = calloc(bitmap->bytes_per_row, size.h);
+  const int palette_size = prv_palette_size(format);
+  if (palette_size > 0) {
+    bitmap->palette = calloc(palette_size, sizeof(GColor));
+    bitmap->palette[0] = GColorWhite;
+    bitmap->palette[1] = palette_size > 2 ? GColorLightGray : GColorBlack;
+    if (palette_size > 2) {
+      bitmap->palette[2] = GColorBlack;
+    }
+  }
+  bitmap->owns_memory = true;
+  return bitmap;
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx) {
+  if (!s_frame_buffer) {
+    s_frame_buffer = prv_bitmap_create(g_sim_platform->screen,
+                                       g_sim_platform->framebuffer_format);
+  }
+  return s_frame_buffer;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+  return buffer == s_frame_buffer;
+}
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id) {
+  for (size_t i = 0; i < sizeof(s_sim_image_resources) / sizeof(s_sim_image_resources[0]); ++i) {
+    if (s_sim_image_resources[i].id == resource_id) {
+      g_sim_stats.gbitmaps_created++;
+      return prv_bitmap_create(s_sim_image_resources[i].size, g_sim_platform->image_format);
+    }
+  }
+  return NULL;
+}
+
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect) {
+  GBitmap *bitmap = malloc(sizeof(GBitmap));
+  *bitmap = *base_bitmap;
+  bitmap->bounds = sub_rect;
+  bitmap->owns_memory = false;
+  g_sim_stats.gbitmap_subs_created++;
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+  if (!bitmap) {
+    return;
+  }
+  if (bitmap->owns_memory) {
+    free(bitmap->data);
+    free(bitmap->palette);
+  }
+  g_sim_stats.gbitmaps_destroyed++;
+  free(bitmap);
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+  return bitmap->bounds;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+  return bitmap->bytes_per_row;
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap) {
+  return bitmap->data;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap) {
+  return bitmap->format;
+}
+
+GColor *gbitmap_get_palette(const GBitmap *bitmap) {
+  return bitmap->palette;
+}
+
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y) {
+  GBitmapDataRowInfo info = {
+    .data = bitmap->data + y * bitmap->bytes_per_row,
+    .min_x = 0,
+    .max_x = bitmap->bounds.size.w - 1,
+  };
+  if (bitmap->format == GBitmapFormat8BitCircular) {
+    /* Only the pixels inside the display circle exist in each row. */
+    const int diameter = bitmap->bounds.size.w;
+    const int dy = 2 * y + 1 - bitmap->bounds.size.h;
+    int min_x = 0;
+    while (min_x < diameter / 2) {
+      const int dx = 2 * min_x + 1 - diameter;
+      if (dx * dx + dy * dy <= diameter * diameter) {
+        break;
+      }
+      ++min_x;
+    }
+    info.min_x = min_x;
+    info.max_x = diameter - 1 - min_x;
+  }
+  return info;
+}
+
+/* Fonts and resources */
+
+static int s_font_handle;
+
+GFont fonts_load_custom_font(ResHandle handle) {
+  return &s_font_handle;
+}
+
+void fonts_unload_custom_font(GFont font) {
+}
+
+GFont fonts_get_system_font(const char *font_key) {
+  return &s_font_handle;
+}
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+  return (ResHandle)(uintptr_t)resource_id;
+}
+
+const SimPlatform *sim_find_platform(const char *name) {
+  for (size_t i = 0; i < sizeof(s_platforms) / sizeof(s_platforms[0]); ++i) {
+    if (strcmp(s_platforms[i].name, name) == 0) {
+      return &s_platforms[i];
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <pebble.h>
+
+/* Everything the day replay reports. Counters only ever grow. */
+typedef struct SimStats {
+  uint32_t messages_sent;
+  uint32_t messages_send_failed;
+  uint32_t messages_outbox_busy;
+  uint32_t messages_dict_overflow;
+  uint32_t messages_received;
+  uint32_t messages_dropped;
+  uint32_t bytes_sent;
+  uint32_t bytes_received;
+  uint32_t persist_writes;
+  uint32_t persist_bytes;
+  uint32_t gbitmaps_created;
+  uint32_t gbitmap_subs_created;
+  uint32_t gbitmaps_destroyed;
+  uint32_t layer_invalidations;
+  uint64_t dirty_pixels;
+  uint32_t frames_rendered;
+  uint32_t draw_calls;
+  uint32_t ticks_second;
+  uint32_t ticks_minute;
+  uint32_t tap_wakeups;
+} SimStats;
+
+typedef struct SimPlatform {
+  const char *name;
+  GSize screen;
+  GBitmapFormat framebuffer_format;
+  /* Format the SDK would convert a 3-colour PNG into on this platform. */
+  GBitmapFormat image_format;
+} SimPlatform;
+
+extern SimStats g_sim_stats;
+extern const SimPlatform *g_sim_platform;
+
+/* day.c: replays the scripted day; called from app_event_loop(). */
+void sim_replay(void);
+
+/* pebble_sim.c: virtual clock and service state driven by the replay. */
+void sim_set_time(time_t now);
+/* Sets the link state. The connection handler only runs when `notify` is
+ * set, so a link can die before the app hears about it. */
+void sim_set_bluetooth(bool connected, bool notify);
+void sim_set_battery(BatteryChargeState state);
+void sim_tap(void);
+void sim_tick(TimeUnits units_changed);
+TimeUnits sim_tick_units(void);
+void sim_render_if_dirty(void);
+
+/* Draws `layer` and its children into the framebuffer without counting a
+ * frame. */
+void sim_render_layer(Layer *layer);
+
+/* Hands the pending outbox message, if any, to `deliver` and frees the
+ * outbox. Called after every handler returns, like an ACK would. */
+typedef void (*SimOutboxDelivery)(const DictionaryIterator *iter);
+void sim_flush_outbox(SimOutboxDelivery deliver);
+
+/* Runs the inbox handler on a message built by the caller. Counts it as
+ * dropped when Bluetooth is down or it does not fit the inbox. */
+void sim_deliver_inbox(const uint8_t *dict, size_t size);
+
+/* Helpers for building inbound dictionaries. */
+void sim_dict_init(DictionaryIterator *iter, uint8_t *buffer, size_t size);
+size_t sim_dict_size(const DictionaryIterator *iter);
+
+/* Looks up a platform by SDK name; NULL when unknown. */
+const SimPlatform *sim_find_platform(const char *name);
@@ -0,0 +1,87 @@
+/* Exercises the polled top-bar refresh path. No shipped widget polls yet,
+ * so the slots are reconfigured as minute and hour widgets with scripted
+ * poll results; a widget must be dirtied exactly when it is due and its
+ * poll returns true (or it has no poll). */
+
+#define main happymac_main
+#include "../src/c/HappyMac.c"
+#undef main
+
+#include "sim.h"
+
+#define CHECK_MINUTES (3 * 60)
+
+void sim_replay(void) {
+}
+
+static uint32_t s_polls;
+
+/* True on every third poll. */
+static bool check_poll(void) {
+  return ++s_polls % 3 == 0;
+}
+
+typedef struct {
+  const char *name;
+  WidgetRefresh refresh;
+  bool (*poll)(void);
+  uint32_t expected_polls;
+  uint32_t expected_dirty;
+} PollCase;
+
+static int run_case(const PollCase *test) {
+  const TopBarWidget saved = s_top_bar_widgets[TOP_BAR_WIDGET_WEATHER];
+  s_top_bar_widgets[TOP_BAR_WIDGET_WEATHER].refresh = test->refresh;
+  s_top_bar_widgets[TOP_BAR_WIDGET_WEATHER].poll = test->poll;
+  s_polls = 0;
+
+  uint32_t dirty = 0;
+  for (int minute = 1; minute <= CHECK_MINUTES; ++minute) {
+    TimeUnits units = SECOND_UNIT | MINUTE_UNIT;
+    if (minute % 60 == 0) {
+      units |= HOUR_UNIT;
+    }
+    const uint32_t invalidations = g_sim_stats.layer_invalidations;
+    const uint32_t polls = s_polls;
+    top_bar_tick(units);
+    const uint32_t marked = g_sim_stats.layer_invalidations - invalidations;
+    const bool polled = s_polls != polls;
+    /* Marked at most once, and only on a poll that said true. */
+    if (marked > 1 || (test->poll && marked && !(polled && s_polls % 3 == 0))) {
+      fprintf(stderr, "%s: minute %d marked %u layers\n", test->name, minute, marked);
+      return 1;
+    }
+    dirty += marked;
+  }
+  s_top_bar_widgets[TOP_BAR_WIDGET_WEATHER] = saved;
+
+  printf("%s %s: %u polls, %u redraws\n", SIM_PLATFORM, test->name, s_polls, dirty);
+  if (s_polls != test->expected_polls || dirty != test->expected_dirty) {
+    fprintf(stderr, "%s: expected %u polls, %u redraws\n", test->name,
+            test->expected_polls, test->expected_dirty);
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  g_sim_platform = sim_find_platform(SIM_PLATFORM);
+  s_window = window_create();
+  window_set_window_handlers(s_window, (WindowHandlers) {
+    .load = prv_window_load,
+  });
+  window_stack_push(s_window, false);
+
+  static const PollCase cases[] = {
+    { "minute widget", WIDGET_REFRESH_MINUTE, check_poll,
+      CHECK_MINUTES, CHECK_MINUTES / 3 },
+    { "hour widget", WIDGET_REFRESH_HOUR, check_poll, 3, 1 },
+    { "minute widget without poll", WIDGET_REFRESH_MINUTE, NULL, 0, CHECK_MINUTES },
+    { "event widget", WIDGET_REFRESH_EVENT, check_poll, 0, 0 },
+  };
+  int failures = 0;
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    failures += run_case(&cases[i]);
+  }
+  return failures ? 1 : 0;
+}
@@ -2,18 +2,28 @@
 #include <ctype.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 #include "message_keys.auto.h"
 
+/* MATRIX_RENDERER=rects pebble build (see wscript) sets this to 0 and draws
+ * the sprite through graphics_fill_rect only; that path is the pixel
+ * reference. */
+#ifndef MATRIX_FRAMEBUFFER_RENDERER
+#define MATRIX_FRAMEBUFFER_RENDERER 1
+#endif
+
 static Window *s_window;
 static TextLayer *s_date_layer;
 static TextLayer *s_time_layer;
 static Layer *s_line_layer;
-static Layer *s_corner_line_layer;
 static Layer *s_matrix_layer;
-static Layer *s_battery_layer;
-static BitmapLayer *s_weather_icon_layer;
-static TextLayer *s_weather_temp_layer;
+static Layer *s_seconds_layer;
+static char s_seconds_text[4];
+static GBitmap *s_weather_atlas_bitmap;
 static GBitmap *s_weather_icon_bitmap;
+static bool s_weather_atlas_inverted = false;
+static int s_weather_icon_index = 0;
+static char s_weather_temp_text[8];
 static GFont s_date_font;
 static GFont s_time_font;
 static BatteryChargeState s_battery_state;
@@ -28,6 +38,11 @@ static int16_t s_weather_temp = INT16_MAX;
 static uint8_t s_weather_code = 255;
 static time_t s_last_weather = 0;
 static uint8_t s_weather_retry_count = 0;
+static bool s_seconds_enabled = false;
+static uint8_t s_seconds_timeout = 5;
+static TimeUnits s_tick_units = 0;
+static bool s_accel_tap_subscribed = false;
+static time_t s_last_motion = 0;
 
 enum {
   THEME_LIGHT = 0,
@@ -44,16 +59,53 @@ enum {
   PERSIST_KEY_WEATHER_UNIT = 4,
   PERSIST_KEY_WEATHER_TEMP = 5,
   PERSIST_KEY_WEATHER_CODE = 6,
+  PERSIST_KEY_SECONDS_ENABLED = 7,
+  PERSIST_KEY_SECONDS_TIMEOUT = 8,
 };
 
+/* Fixed top-bar slots. On round displays the left slot moves to a centred
+ * band at the bottom of the screen. */
+enum {
+  TOP_BAR_SLOT_LEFT = 0,
+  TOP_BAR_SLOT_RIGHT = 1,
+};
+
+typedef enum {
+  WIDGET_REFRESH_EVENT = 0,
+  WIDGET_REFRESH_MINUTE = 1,
+  WIDGET_REFRESH_HOUR = 2,
+} WidgetRefresh;
+
+typedef enum {
+  TOP_BAR_WIDGET_WEATHER = 0,
+  TOP_BAR_WIDGET_BATTERY,
+  TOP_BAR_WIDGET_COUNT,
+} TopBarWidgetId;
+
+/* Event widgets are dirtied by their data source through top_bar_mark_dirty().
+ * Minute and hour widgets are polled from the tick handler and redrawn only
+ * when `poll` is NULL or returns true. */
+typedef struct {
+  uint8_t slot;
+  GSize size;
+  WidgetRefresh refresh;
+  LayerUpdateProc draw;
+  bool (*poll)(void);
+} TopBarWidget;
+
+static Layer *s_top_bar_layers[TOP_BAR_WIDGET_COUNT];
+
 static void apply_theme(void);
-static void update_weather_visibility(void);
+static void top_bar_tick(TimeUnits units_changed);
+static void update_tick_subscription(void);
 static void update_weather_icon(void);
 static void update_weather_temp_text(void);
-static void update_weather_layout(void);
 static void request_weather(void);
+static bool weather_request_due(void);
+static void write_weather_request(DictionaryIterator *iter);
 static bool tuple_value_to_bool(const Tuple *tuple, bool fallback);
-static void send_settings_to_phone(void);
+static uint32_t settings_hash(void);
+static void send_settings_to_phone(bool full);
 static void connection_handler(bool connected);
 static const uint8_t s_matrix[32][31] = {
   {0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0},
@@ -126,31 +178,14 @@ static const uint8_t s_color_matrix[32][25] = {
 };
 
 #define WEATHER_INTERVAL (30 * 60)
+#define SETTINGS_HASH_VERSION 2
 #define WEATHER_ICON_SIZE 17
-
-static const uint32_t s_weather_icon_light_resources[9] = {
-  RESOURCE_ID_WEATHER_LIGHT_1,
-  RESOURCE_ID_WEATHER_LIGHT_2,
-  RESOURCE_ID_WEATHER_LIGHT_3,
-  RESOURCE_ID_WEATHER_LIGHT_4,
-  RESOURCE_ID_WEATHER_LIGHT_5,
-  RESOURCE_ID_WEATHER_LIGHT_6,
-  RESOURCE_ID_WEATHER_LIGHT_7,
-  RESOURCE_ID_WEATHER_LIGHT_8,
-  RESOURCE_ID_WEATHER_LIGHT_9
-};
-
-static const uint32_t s_weather_icon_dark_resources[9] = {
-  RESOURCE_ID_WEATHER_DARK_1,
-  RESOURCE_ID_WEATHER_DARK_2,
-  RESOURCE_ID_WEATHER_DARK_3,
-  RESOURCE_ID_WEATHER_DARK_4,
-  RESOURCE_ID_WEATHER_DARK_5,
-  RESOURCE_ID_WEATHER_DARK_6,
-  RESOURCE_ID_WEATHER_DARK_7,
-  RESOURCE_ID_WEATHER_DARK_8,
-  RESOURCE_ID_WEATHER_DARK_9
-};
+#define WEATHER_TEMP_WIDTH 50
+#define WEATHER_TEMP_HEIGHT 16
+#define BATTERY_SEGMENT_COUNT 4
+#define SECONDS_WIDTH 18
+#define SECONDS_HEIGHT 14
+#define SECONDS_LOW_BATTERY_PERCENT 20
 
 static int weather_icon_index_from_code(uint8_t code) {
   switch (code) {
@@ -240,9 +275,29 @@ static GColor color_from_index(uint8_t index) {
   }
 }
 
+static void top_bar_mark_dirty(TopBarWidgetId id) {
+  if (s_top_bar_layers[id]) {
+    layer_mark_dirty(s_top_bar_layers[id]);
+  }
+}
+
+static void update_seconds_text(const struct tm *tick_time) {
+  snprintf(s_seconds_text, sizeof(s_seconds_text), "%02d", tick_time->tm_sec);
+  if (s_seconds_layer) {
+    layer_mark_dirty(s_seconds_layer);
+  }
+}
+
 static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
-  update_time();
-  request_weather();
+  if (units_changed & MINUTE_UNIT) {
+    update_time();
+    top_bar_tick(units_changed);
+    request_weather();
+  }
+  if (s_tick_units == SECOND_UNIT) {
+    update_seconds_text(tick_time);
+    update_tick_subscription();
+  }
 }
 
 static void line_layer_update_proc(Layer *layer, GContext *ctx) {
@@ -251,15 +306,8 @@ static void line_layer_update_proc(Layer *layer, GContext *ctx) {
   graphics_fill_rect(ctx, bounds, 0, GCornerNone);
 }
 
-static void matrix_layer_update_proc(Layer *layer, GContext *ctx) {
-  GRect bounds = layer_get_bounds(layer);
-  const int pixel_size = bounds.size.w < 190 ? 2 : 3;
-  const int matrix_cols = (s_theme == THEME_COLOR) ? 25 : 31;
-  const int matrix_width = matrix_cols * pixel_size;
-  const int matrix_height = 32 * pixel_size;
-  const int origin_x = (bounds.size.w - matrix_width) / 2;
-  const int origin_y = (bounds.size.h * 2 / 5) - (matrix_height / 2);
-
+static void matrix_fill_rects(GContext *ctx, int pixel_size, int matrix_cols,
+                              int origin_x, int origin_y) {
   for (int row = 0; row < 32; ++row) {
     for (int col = 0; col < matrix_cols; ++col) {
       if (s_theme == THEME_COLOR) {
@@ -283,6 +331,168 @@ static void matrix_layer_update_proc(Layer *layer, GContext *ctx) {
   }
 }
 
+#if MATRIX_FRAMEBUFFER_RENDERER
+static uint8_t matrix_cell(int row, int col) {
+  return (s_theme == THEME_COLOR) ? s_color_matrix[row][col] : s_matrix[row][col];
+}
+
+/* 1-bit rows are LSB-first; set bits are white. Edge pixels are masked in
+ * one at a time, everything between them is written a byte at a time. */
+static void matrix_fill_span_1bit(uint8_t *row, int x0, int x1, bool white) {
+  while (x0 < x1 && (x0 & 7)) {
+    if (white) {
+      row[x0 >> 3] |= (uint8_t)(1 << (x0 & 7));
+    } else {
+      row[x0 >> 3] &= (uint8_t)~(1 << (x0 & 7));
+    }
+    ++x0;
+  }
+  const int whole_bytes = (x1 - x0) >> 3;
+  if (whole_bytes > 0) {
+    memset(row + (x0 >> 3), white ? 0xFF : 0x00, whole_bytes);
+    x0 += whole_bytes << 3;
+  }
+  while (x0 < x1) {
+    if (white) {
+      row[x0 >> 3] |= (uint8_t)(1 << (x0 & 7));
+    } else {
+      row[x0 >> 3] &= (uint8_t)~(1 << (x0 & 7));
+    }
+    ++x0;
+  }
+}
+
+/* Writes runs of equal sprite cells straight into the framebuffer. Returns
+ * false when the caller has to use matrix_fill_rects instead. The matrix
+ * layer covers the whole window, so layer and screen coordinates match. */
+static bool matrix_fill_framebuffer(GContext *ctx, int pixel_size, int matrix_cols,
+                                    int origin_x, int origin_y) {
+#ifndef PBL_COLOR
+  /* Gray palette entries are dithered by graphics_fill_rect on B/W. */
+  if (s_theme == THEME_COLOR) {
+    return false;
+  }
+#endif
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (!frame_buffer) {
+    return false;
+  }
+  const GBitmapFormat format = gbitmap_get_format(frame_buffer);
+#ifdef PBL_COLOR
+  if (format != GBitmapFormat1Bit && format != GBitmapFormat8Bit &&
+      format != GBitmapFormat8BitCircular) {
+#else
+  /* Aplite's SDK has no 8-bit formats or gbitmap_get_data_row_info. */
+  if (format != GBitmapFormat1Bit) {
+#endif
+    graphics_release_frame_buffer(ctx, frame_buffer);
+    return false;
+  }
+  const GRect fb_bounds = gbitmap_get_bounds(frame_buffer);
+  uint8_t *fb_data = gbitmap_get_data(frame_buffer);
+  const uint16_t fb_bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+
+  for (int row = 0; row < 32; ++row) {
+    int col = 0;
+    while (col < matrix_cols) {
+      const uint8_t value = matrix_cell(row, col);
+      int end = col + 1;
+      while (end < matrix_cols && matrix_cell(row, end) == value) {
+        ++end;
+      }
+      if (value != 0) {
+        const GColor color =
+            (s_theme == THEME_COLOR) ? color_from_index(value) : s_foreground_color;
+        const int span_x0 = origin_x + col * pixel_size;
+        const int span_x1 = origin_x + end * pixel_size;
+        for (int dy = 0; dy < pixel_size; ++dy) {
+          const int y = origin_y + row * pixel_size + dy;
+          if (y < 0 || y >= fb_bounds.size.h) {
+            continue;
+          }
+          int x0 = span_x0;
+          int x1 = span_x1;
+          if (format == GBitmapFormat1Bit) {
+            x0 = x0 < 0 ? 0 : x0;
+            x1 = x1 > fb_bounds.size.w ? fb_bounds.size.w : x1;
+            if (x0 < x1) {
+              matrix_fill_span_1bit(fb_data + y * fb_bytes_per_row, x0, x1,
+                                    gcolor_equal(color, GColorWhite));
+            }
+          }
+#ifdef PBL_COLOR
+          else {
+            const GBitmapDataRowInfo info = gbitmap_get_data_row_info(frame_buffer, y);
+            x0 = x0 < info.min_x ? info.min_x : x0;
+            x1 = x1 > info.max_x + 1 ? info.max_x + 1 : x1;
+            if (x0 < x1) {
+              memset(info.data + x0, color.argb, x1 - x0);
+            }
+          }
+#endif
+        }
+      }
+      col = end;
+    }
+  }
+
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  return true;
+}
+#endif
+
+static int matrix_pixel_size(GRect bounds) {
+  return bounds.size.w < 190 ? 2 : 3;
+}
+
+/* The Color sprite is narrower than the outline one. */
+static int matrix_columns(void) {
+  return (s_theme == THEME_COLOR) ? 25 : 31;
+}
+
+/* Just right of the current sprite, bottom-aligned with it. */
+static GRect seconds_layer_frame(GRect bounds) {
+  const int pixel_size = matrix_pixel_size(bounds);
+  const int matrix_width = matrix_columns() * pixel_size;
+  const int x = (bounds.size.w - matrix_width) / 2 + matrix_width + 2;
+  const int y = (bounds.size.h * 2 / 5) + (32 * pixel_size / 2) - SECONDS_HEIGHT;
+  return GRect(x, y, SECONDS_WIDTH, SECONDS_HEIGHT);
+}
+
+static void matrix_layer_update_proc(Layer *layer, GContext *ctx) {
+  GRect bounds = layer_get_bounds(layer);
+  const int pixel_size = matrix_pixel_size(bounds);
+  const int matrix_cols = matrix_columns();
+  const int matrix_width = matrix_cols * pixel_size;
+  const int matrix_height = 32 * pixel_size;
+  const int origin_x = (bounds.size.w - matrix_width) / 2;
+  const int origin_y = (bounds.size.h * 2 / 5) - (matrix_height / 2);
+
+#if MATRIX_FRAMEBUFFER_RENDERER
+  if (matrix_fill_framebuffer(ctx, pixel_size, matrix_cols, origin_x, origin_y)) {
+    return;
+  }
+#endif
+  matrix_fill_rects(ctx, pixel_size, matrix_cols, origin_x, origin_y);
+}
+
+/* Paints its own background so the readout never depends on what the
+ * other layers drew. A tick only invalidates this box, but the firmware
+ * still re-renders the whole window tree for it. */
+static void seconds_layer_update_proc(Layer *layer, GContext *ctx) {
+  GRect bounds = layer_get_bounds(layer);
+  graphics_context_set_fill_color(ctx, s_background_color);
+  graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+  graphics_context_set_text_color(ctx, s_foreground_color);
+  graphics_draw_text(ctx, s_seconds_text, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
+                     GRect(0, -3, bounds.size.w, bounds.size.h + 3),
+                     GTextOverflowModeFill, GTextAlignmentLeft, NULL);
+}
+
+static int battery_filled_segments(uint8_t charge_percent) {
+  return (charge_percent * BATTERY_SEGMENT_COUNT + 99) / 100;
+}
+
 static void battery_layer_update_proc(Layer *layer, GContext *ctx) {
   GRect bounds = layer_get_bounds(layer);
   GRect body = GRect(0, 0, bounds.size.w - 3, bounds.size.h);
@@ -292,12 +502,12 @@ static void battery_layer_update_proc(Layer *layer, GContext *ctx) {
   graphics_fill_rect(ctx, body, 0, GCornerNone);
   graphics_fill_rect(ctx, nub, 0, GCornerNone);
 
-  const int segment_count = 4;
+  const int segment_count = BATTERY_SEGMENT_COUNT;
   const int segment_gap = 1;
   const int inner_width = body.size.w - 4;
   const int inner_height = body.size.h - 4;
   const int segment_width = (inner_width - (segment_gap * (segment_count - 1))) / segment_count;
-  const int filled_segments = (s_battery_state.charge_percent * segment_count + 99) / 100;
+  const int filled_segments = battery_filled_segments(s_battery_state.charge_percent);
 
   graphics_context_set_fill_color(ctx, s_background_color);
   for (int i = 0; i < segment_count; ++i) {
@@ -310,10 +520,169 @@ static void battery_layer_update_proc(Layer *layer, GContext *ctx) {
   }
 }
 
+static void weather_widget_update_proc(Layer *layer, GContext *ctx) {
+  GRect bounds = layer_get_bounds(layer);
+  if (!s_weather_enabled) {
+#ifndef PBL_ROUND
+    graphics_context_set_fill_color(ctx, s_foreground_color);
+    graphics_fill_rect(ctx, GRect(0, bounds.size.h / 2, 12, 2), 0, GCornerNone);
+#endif
+    return;
+  }
+
+#ifdef PBL_ROUND
+  const int icon_gap = 2;
+  const int center_x = bounds.size.w / 2;
+  const int icon_x = s_weather_show_temp
+                         ? center_x - (icon_gap / 2) - WEATHER_ICON_SIZE
+                         : (bounds.size.w - WEATHER_ICON_SIZE) / 2;
+  const int temp_x = center_x + (icon_gap / 2);
+#else
+  const int icon_x = 0;
+  const int temp_x = WEATHER_ICON_SIZE + 2;
+#endif
+
+  if (s_weather_icon_bitmap) {
+    /* Bitmaps without a palette (aplite) are inverted while drawing. */
+    const bool invert = s_weather_atlas_inverted &&
+                        !gbitmap_get_palette(s_weather_atlas_bitmap);
+    if (invert) {
+      graphics_context_set_compositing_mode(ctx, GCompOpAssignInverted);
+    }
+    graphics_draw_bitmap_in_rect(ctx, s_weather_icon_bitmap,
+                                 GRect(icon_x, 1, WEATHER_ICON_SIZE, WEATHER_ICON_SIZE));
+    if (invert) {
+      graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+    }
+  }
+  if (s_weather_show_temp && s_weather_temp_text[0] != '\0') {
+    graphics_context_set_text_color(ctx, s_foreground_color);
+    graphics_draw_text(ctx, s_weather_temp_text,
+                       fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
+                       GRect(temp_x, 0, WEATHER_TEMP_WIDTH, WEATHER_TEMP_HEIGHT),
+                       GTextOverflowModeWordWrap, GTextAlignmentLeft, NULL);
+  }
+}
+
+/* Not const: sim/top_bar_check.c swaps in polled widgets to exercise the
+ * minute and hour paths, which no shipped widget uses yet. */
+static TopBarWidget s_top_bar_widgets[TOP_BAR_WIDGET_COUNT] = {
+  [TOP_BAR_WIDGET_WEATHER] = {
+    .slot = TOP_BAR_SLOT_LEFT,
+    .size = { WEATHER_ICON_SIZE + 2 + WEATHER_TEMP_WIDTH, WEATHER_ICON_SIZE + 1 },
+    .refresh = WIDGET_REFRESH_EVENT,
+    .draw = weather_widget_update_proc,
+  },
+  [TOP_BAR_WIDGET_BATTERY] = {
+    .slot = TOP_BAR_SLOT_RIGHT,
+    .size = { 26, 10 },
+    .refresh = WIDGET_REFRESH_EVENT,
+    .draw = battery_layer_update_proc,
+  },
+};
+
+static GRect top_bar_slot_frame(const TopBarWidget *widget, GRect bounds, int line_y) {
+  const GSize size = widget->size;
+  switch (widget->slot) {
+    case TOP_BAR_SLOT_RIGHT: {
+      const int margin = (line_y - size.h) / 2;
+      return GRect(bounds.size.w - size.w - margin, margin, size.w, size.h);
+    }
+    case TOP_BAR_SLOT_LEFT:
+    default:
+#ifdef PBL_ROUND
+      return GRect(0, bounds.size.h - size.h - 10, bounds.size.w, size.h);
+#else
+      return GRect(4, (line_y / 2) - (size.h / 2), size.w, size.h);
+#endif
+  }
+}
+
+static void top_bar_tick(TimeUnits units_changed) {
+  for (int i = 0; i < TOP_BAR_WIDGET_COUNT; ++i) {
+    const TopBarWidget *widget = &s_top_bar_widgets[i];
+    const bool due =
+        (widget->refresh == WIDGET_REFRESH_MINUTE && (units_changed & MINUTE_UNIT)) ||
+        (widget->refresh == WIDGET_REFRESH_HOUR && (units_changed & HOUR_UNIT));
+    if (due && (!widget->poll || widget->poll())) {
+      top_bar_mark_dirty((TopBarWidgetId)i);
+    }
+  }
+}
+
 static void battery_handler(BatteryChargeState state) {
+  const bool changed = battery_filled_segments(state.charge_percent) !=
+                       battery_filled_segments(s_battery_state.charge_percent);
   s_battery_state = state;
-  if (s_battery_layer) {
-    layer_mark_dirty(s_battery_layer);
+  if (changed) {
+    top_bar_mark_dirty(TOP_BAR_WIDGET_BATTERY);
+  }
+  update_tick_subscription();
+}
+
+static void accel_tap_handler(AccelAxisType axis, int32_t direction) {
+  s_last_motion = time(NULL);
+  update_tick_subscription();
+}
+
+/* True when the sprite is drawn one graphics_fill_rect per cell. */
+static bool matrix_uses_fill_rects(void) {
+#if !MATRIX_FRAMEBUFFER_RENDERER
+  return true;
+#elif !defined(PBL_COLOR)
+  return s_theme == THEME_COLOR;
+#else
+  return false;
+#endif
+}
+
+/* Whether a wrist tap could turn seconds on right now. */
+static bool seconds_possible(void) {
+  if (!s_seconds_enabled) {
+    return false;
+  }
+  /* Any dirty layer re-renders the whole window, sprite included; at
+   * roughly 700 fill calls per frame that is too costly every second. */
+  if (matrix_uses_fill_rects()) {
+    return false;
+  }
+  return s_battery_state.is_charging ||
+         s_battery_state.charge_percent > SECONDS_LOW_BATTERY_PERCENT;
+}
+
+static bool seconds_active(void) {
+  return seconds_possible() &&
+         time(NULL) - s_last_motion < (time_t)s_seconds_timeout * 60;
+}
+
+/* Ticks every second only while seconds are shown; low battery, no wrist
+ * motion for s_seconds_timeout minutes, or a sprite that has to be drawn
+ * through matrix_fill_rects falls back to minute ticks. */
+static void update_tick_subscription(void) {
+  /* Taps only wake the app while they can bring the seconds back. */
+  const bool want_taps = seconds_possible();
+  if (want_taps != s_accel_tap_subscribed) {
+    if (want_taps) {
+      accel_tap_service_subscribe(accel_tap_handler);
+    } else {
+      accel_tap_service_unsubscribe();
+    }
+    s_accel_tap_subscribed = want_taps;
+  }
+
+  const bool active = seconds_active();
+  const TimeUnits units = active ? SECOND_UNIT : MINUTE_UNIT;
+  if (units == s_tick_units) {
+    return;
+  }
+  s_tick_units = units;
+  tick_timer_service_subscribe(units, tick_handler);
+  if (active) {
+    const time_t now = time(NULL);
+    update_seconds_text(localtime(&now));
+  }
+  if (s_seconds_layer) {
+    layer_set_hidden(s_seconds_layer, !active);
   }
 }
 
@@ -323,7 +692,7 @@ static void connection_handler(bool connected) {
     /* APP_LOG(APP_LOG_LEVEL_INFO, "bluetooth connected, request weather"); */
     s_last_weather = 0;
     s_weather_retry_count = 0;
-    request_weather();
+    send_settings_to_phone(false);
   } else {
     /* APP_LOG(APP_LOG_LEVEL_INFO, "bluetooth disconnected"); */
   }
@@ -356,139 +725,161 @@ static void apply_theme(void) {
   if (s_line_layer) {
     layer_mark_dirty(s_line_layer);
   }
-  if (s_corner_line_layer) {
-    layer_mark_dirty(s_corner_line_layer);
-  }
   if (s_matrix_layer) {
     layer_mark_dirty(s_matrix_layer);
   }
-  if (s_battery_layer) {
-    layer_mark_dirty(s_battery_layer);
+  if (s_seconds_layer) {
+    layer_set_frame(s_seconds_layer,
+                    seconds_layer_frame(layer_get_bounds(window_get_root_layer(s_window))));
+    layer_mark_dirty(s_seconds_layer);
   }
-  if (s_weather_temp_layer) {
-    text_layer_set_text_color(s_weather_temp_layer, s_foreground_color);
+  for (int i = 0; i < TOP_BAR_WIDGET_COUNT; ++i) {
+    top_bar_mark_dirty((TopBarWidgetId)i);
   }
   update_weather_icon();
 }
 
-static void send_settings_to_phone(void) {
+/* Packs every synced setting into one word; index.js computes the same value
+ * from its Clay settings, so equal hashes mean both sides already agree.
+ * sim/day.c keeps a third copy for the phone model. */
+static uint32_t settings_hash(void) {
+  return ((uint32_t)(s_theme & 0xFF)) |
+         ((uint32_t)(s_weather_enabled ? 1 : 0) << 8) |
+         ((uint32_t)(s_weather_show_temp ? 1 : 0) << 9) |
+         ((uint32_t)(s_weather_unit & 1) << 10) |
+         ((uint32_t)(s_seconds_enabled ? 1 : 0) << 11) |
+         ((uint32_t)SETTINGS_HASH_VERSION << 16) |
+         ((uint32_t)(s_seconds_timeout & 0x3F) << 24);
+}
+
+/* Always sends the hash; the full settings only when `full` is set. A due
+ * weather request rides along so launch and reconnect cost one message. */
+static void send_settings_to_phone(bool full) {
   DictionaryIterator *iter = NULL;
   if (app_message_outbox_begin(&iter) != APP_MSG_OK || !iter) {
     return;
   }
-  dict_write_int(iter, MESSAGE_KEY_theme, &s_theme, sizeof(s_theme), true);
-  dict_write_uint8(iter, MESSAGE_KEY_WEATHER_ENABLED, s_weather_enabled ? 1 : 0);
-  dict_write_uint8(iter, MESSAGE_KEY_WEATHER_SHOW_TEMP, s_weather_show_temp ? 1 : 0);
-  dict_write_uint8(iter, MESSAGE_KEY_WEATHER_TEMP_UNIT, s_weather_unit);
+  dict_write_uint32(iter, MESSAGE_KEY_SETTINGS_HASH, settings_hash());
+  if (full) {
+    dict_write_int(iter, MESSAGE_KEY_theme, &s_theme, sizeof(s_theme), true);
+    dict_write_uint8(iter, MESSAGE_KEY_WEATHER_ENABLED, s_weather_enabled ? 1 : 0);
+    dict_write_uint8(iter, MESSAGE_KEY_WEATHER_SHOW_TEMP, s_weather_show_temp ? 1 : 0);
+    dict_write_uint8(iter, MESSAGE_KEY_WEATHER_TEMP_UNIT, s_weather_unit);
+    dict_write_uint8(iter, MESSAGE_KEY_SECONDS_ENABLED, s_seconds_enabled ? 1 : 0);
+    dict_write_uint8(iter, MESSAGE_KEY_SECONDS_TIMEOUT, s_seconds_timeout);
+  }
+  if (weather_request_due()) {
+    write_weather_request(iter);
+  }
   app_message_outbox_send();
 }
 
-static void update_weather_visibility(void) {
-  if (s_corner_line_layer) {
-#ifdef PBL_ROUND
-    layer_set_hidden(s_corner_line_layer, true);
-#else
-    layer_set_hidden(s_corner_line_layer, s_weather_enabled);
-#endif
-  }
-  if (s_weather_icon_layer) {
-    layer_set_hidden(bitmap_layer_get_layer(s_weather_icon_layer), !s_weather_enabled);
-  }
-  if (s_weather_temp_layer) {
-    layer_set_hidden(text_layer_get_layer(s_weather_temp_layer),
-                     !s_weather_enabled || !s_weather_show_temp);
+static int weather_atlas_palette_size(void) {
+  switch (gbitmap_get_format(s_weather_atlas_bitmap)) {
+    case GBitmapFormat1BitPalette:
+      return 2;
+    case GBitmapFormat2BitPalette:
+      return 4;
+    case GBitmapFormat4BitPalette:
+      return 16;
+    default:
+      return 0;
   }
-  update_weather_layout();
 }
 
-static void update_weather_layout(void) {
-  if (!s_weather_icon_layer || !s_weather_temp_layer) {
-    return;
+/* The atlas only ships the light icons; the dark set is the same pixels
+ * with every palette entry's RGB inverted. Inverting twice restores it. */
+static bool weather_atlas_set_inverted(bool inverted) {
+  if (inverted == s_weather_atlas_inverted) {
+    return false;
   }
-
-#ifdef PBL_ROUND
-  Layer *root_layer = window_get_root_layer(s_window);
-  GRect bounds = layer_get_bounds(root_layer);
-  const int icon_gap = 2;
-  const int temp_width = 50;
-  const int temp_height = 16;
-  const int icon_y = bounds.size.h - WEATHER_ICON_SIZE - 10;
-  const int temp_y = icon_y + ((WEATHER_ICON_SIZE - temp_height) / 2) - 1;
-  const int center_x = bounds.size.w / 2;
-
-  if (s_weather_enabled && s_weather_show_temp) {
-    const int icon_x = center_x - (icon_gap / 2) - WEATHER_ICON_SIZE;
-    const int temp_x = center_x + (icon_gap / 2);
-    layer_set_frame(bitmap_layer_get_layer(s_weather_icon_layer),
-                    GRect(icon_x, icon_y, WEATHER_ICON_SIZE, WEATHER_ICON_SIZE));
-    layer_set_frame(text_layer_get_layer(s_weather_temp_layer),
-                    GRect(temp_x, temp_y, temp_width, temp_height));
-  } else {
-    const int icon_x = (bounds.size.w - WEATHER_ICON_SIZE) / 2;
-    layer_set_frame(bitmap_layer_get_layer(s_weather_icon_layer),
-                    GRect(icon_x, icon_y, WEATHER_ICON_SIZE, WEATHER_ICON_SIZE));
+  s_weather_atlas_inverted = inverted;
+  GColor *palette = gbitmap_get_palette(s_weather_atlas_bitmap);
+  const int palette_size = palette ? weather_atlas_palette_size() : 0;
+  for (int i = 0; i < palette_size; ++i) {
+    palette[i].argb = (palette[i].argb & 0xC0) | (~palette[i].argb & 0x3F);
   }
-#endif
+  return true;
 }
 
 static void update_weather_icon(void) {
-  if (!s_weather_icon_layer || !s_weather_enabled || s_weather_code == 255) {
-    if (s_weather_icon_layer) {
-      bitmap_layer_set_bitmap(s_weather_icon_layer, NULL);
-    }
+  if (!s_top_bar_layers[TOP_BAR_WIDGET_WEATHER] || !s_weather_enabled || s_weather_code == 255) {
     if (s_weather_icon_bitmap) {
       gbitmap_destroy(s_weather_icon_bitmap);
       s_weather_icon_bitmap = NULL;
+      s_weather_icon_index = 0;
+      top_bar_mark_dirty(TOP_BAR_WIDGET_WEATHER);
     }
     return;
   }
 
-  const int icon_index = weather_icon_index_from_code(s_weather_code);
-  const uint32_t *resources = (s_theme == THEME_DARK)
-                                  ? s_weather_icon_dark_resources
-                                  : s_weather_icon_light_resources;
-  const uint32_t resource_id = resources[icon_index - 1];
+  if (!s_weather_atlas_bitmap) {
+    s_weather_atlas_bitmap = gbitmap_create_with_resource(RESOURCE_ID_WEATHER_ATLAS);
+    s_weather_atlas_inverted = false;
+    if (!s_weather_atlas_bitmap) {
+      return;
+    }
+  }
+  bool changed = weather_atlas_set_inverted(s_theme == THEME_DARK);
 
-  if (s_weather_icon_bitmap) {
-    gbitmap_destroy(s_weather_icon_bitmap);
-    s_weather_icon_bitmap = NULL;
+  const int icon_index = weather_icon_index_from_code(s_weather_code);
+  if (!s_weather_icon_bitmap || icon_index != s_weather_icon_index) {
+    if (s_weather_icon_bitmap) {
+      gbitmap_destroy(s_weather_icon_bitmap);
+    }
+    s_weather_icon_bitmap = gbitmap_create_as_sub_bitmap(
+        s_weather_atlas_bitmap,
+        GRect(0, (icon_index - 1) * WEATHER_ICON_SIZE, WEATHER_ICON_SIZE, WEATHER_ICON_SIZE));
+    s_weather_icon_index = icon_index;
+    changed = true;
+  }
+  if (changed) {
+    top_bar_mark_dirty(TOP_BAR_WIDGET_WEATHER);
   }
-  s_weather_icon_bitmap = gbitmap_create_with_resource(resource_id);
-  bitmap_layer_set_bitmap(s_weather_icon_layer, s_weather_icon_bitmap);
 }
 
 static void update_weather_temp_text(void) {
-  if (!s_weather_temp_layer) {
-    return;
+  char text[sizeof(s_weather_temp_text)] = "";
+  if (s_weather_enabled && s_weather_show_temp && s_weather_temp != INT16_MAX) {
+    const char unit_char = s_weather_unit == 1 ? 'F' : 'C';
+    snprintf(text, sizeof(text), "%d%c", s_weather_temp, unit_char);
   }
-  if (!s_weather_enabled || !s_weather_show_temp || s_weather_temp == INT16_MAX) {
-    text_layer_set_text(s_weather_temp_layer, "");
-    return;
+  if (strcmp(text, s_weather_temp_text) != 0) {
+    strncpy(s_weather_temp_text, text, sizeof(s_weather_temp_text));
+    top_bar_mark_dirty(TOP_BAR_WIDGET_WEATHER);
   }
-
-  static char s_temp_buffer[8];
-  const char unit_char = s_weather_unit == 1 ? 'F' : 'C';
-  snprintf(s_temp_buffer, sizeof(s_temp_buffer), "%d%c", s_weather_temp, unit_char);
-  text_layer_set_text(s_weather_temp_layer, s_temp_buffer);
 }
 
-static void request_weather(void) {
+static bool weather_request_due(void) {
   if (!s_weather_enabled) {
     /* APP_LOG(APP_LOG_LEVEL_INFO, "weather request skipped: disabled"); */
-    return;
+    return false;
   }
   if (!s_bt_connected) {
     /* APP_LOG(APP_LOG_LEVEL_INFO, "weather request skipped: disconnected"); */
-    return;
+    return false;
   }
 
   const time_t now = time(NULL);
   if (s_last_weather != 0 && s_last_weather + WEATHER_INTERVAL > now) {
     /* APP_LOG(APP_LOG_LEVEL_INFO, "weather request skipped: throttled"); */
-    return;
+    return false;
   }
   if (s_weather_retry_count >= 10) {
     /* APP_LOG(APP_LOG_LEVEL_INFO, "weather request skipped: retry limit"); */
+    return false;
+  }
+  return true;
+}
+
+static void write_weather_request(DictionaryIterator *iter) {
+  /* APP_LOG(APP_LOG_LEVEL_INFO, "weather request unit=%u", s_weather_unit); */
+  dict_write_uint8(iter, MESSAGE_KEY_WEATHER_REQUEST, s_weather_unit);
+  s_weather_retry_count++;
+}
+
+static void request_weather(void) {
+  if (!weather_request_due()) {
     return;
   }
 
@@ -497,10 +888,8 @@ static void request_weather(void) {
     /* APP_LOG(APP_LOG_LEVEL_ERROR, "weather request: outbox begin failed"); */
     return;
   }
-  /* APP_LOG(APP_LOG_LEVEL_INFO, "weather request unit=%u", s_weather_unit); */
-  dict_write_uint8(iter, MESSAGE_KEY_WEATHER_REQUEST, s_weather_unit);
+  write_weather_request(iter);
   app_message_outbox_send();
-  s_weather_retry_count++;
 }
 
 static bool tuple_value_to_bool(const Tuple *tuple, bool fallback) {
@@ -522,7 +911,10 @@ static bool tuple_value_to_bool(const Tuple *tuple, bool fallback) {
 }
 
 static void inbox_received_handler(DictionaryIterator *iter, void *context) {
+  bool settings_received = false;
   bool weather_settings_changed = false;
+  bool seconds_settings_changed = false;
+  bool theme_changed = false;
   bool weather_unit_changed = false;
   Tuple *theme_tuple = dict_find(iter, MESSAGE_KEY_theme);
   if (theme_tuple) {
@@ -539,7 +931,8 @@ static void inbox_received_handler(DictionaryIterator *iter, void *context) {
       s_theme = new_theme;
       persist_write_int(PERSIST_KEY_THEME, s_theme);
       apply_theme();
-      send_settings_to_phone();
+      theme_changed = true;
+      settings_received = true;
     }
   }
 
@@ -548,7 +941,7 @@ static void inbox_received_handler(DictionaryIterator *iter, void *context) {
     s_weather_enabled = tuple_value_to_bool(weather_enabled_tuple, s_weather_enabled);
     persist_write_bool(PERSIST_KEY_WEATHER_ENABLED, s_weather_enabled);
     /* APP_LOG(APP_LOG_LEVEL_INFO, "weather enabled=%d", s_weather_enabled); */
-    send_settings_to_phone();
+    settings_received = true;
     weather_settings_changed = true;
   }
 
@@ -557,7 +950,7 @@ static void inbox_received_handler(DictionaryIterator *iter, void *context) {
     s_weather_show_temp = tuple_value_to_bool(weather_show_temp_tuple, s_weather_show_temp);
     persist_write_bool(PERSIST_KEY_WEATHER_SHOW_TEMP, s_weather_show_temp);
     /* APP_LOG(APP_LOG_LEVEL_INFO, "weather show_temp=%d", s_weather_show_temp); */
-    send_settings_to_phone();
+    settings_received = true;
     weather_settings_changed = true;
   }
 
@@ -575,12 +968,38 @@ static void inbox_received_handler(DictionaryIterator *iter, void *context) {
       s_weather_unit = unit;
       persist_write_int(PERSIST_KEY_WEATHER_UNIT, s_weather_unit);
       /* APP_LOG(APP_LOG_LEVEL_INFO, "weather unit=%u", s_weather_unit); */
-      send_settings_to_phone();
+      settings_received = true;
       weather_settings_changed = true;
       weather_unit_changed = true;
     }
   }
 
+  Tuple *seconds_enabled_tuple = dict_find(iter, MESSAGE_KEY_SECONDS_ENABLED);
+  if (seconds_enabled_tuple) {
+    s_seconds_enabled = tuple_value_to_bool(seconds_enabled_tuple, s_seconds_enabled);
+    persist_write_bool(PERSIST_KEY_SECONDS_ENABLED, s_seconds_enabled);
+    settings_received = true;
+    seconds_settings_changed = true;
+  }
+
+  Tuple *seconds_timeout_tuple = dict_find(iter, MESSAGE_KEY_SECONDS_TIMEOUT);
+  if (seconds_timeout_tuple) {
+    int timeout = s_seconds_timeout;
+    if (seconds_timeout_tuple->type == TUPLE_CSTRING) {
+      timeout = atoi(seconds_timeout_tuple->value->cstring);
+    } else if (seconds_timeout_tuple->type == TUPLE_UINT) {
+      timeout = (int)seconds_timeout_tuple->value->uint32;
+    } else {
+      timeout = (int)seconds_timeout_tuple->value->int32;
+    }
+    if (timeout >= 1 && timeout <= 60) {
+      s_seconds_timeout = (uint8_t)timeout;
+      persist_write_int(PERSIST_KEY_SECONDS_TIMEOUT, s_seconds_timeout);
+      settings_received = true;
+      seconds_settings_changed = true;
+    }
+  }
+
   Tuple *weather_temp_tuple = dict_find(iter, MESSAGE_KEY_WEATHER_TEMP);
   if (weather_temp_tuple) {
     if (weather_temp_tuple->type == TUPLE_INT) {
@@ -609,20 +1028,32 @@ static void inbox_received_handler(DictionaryIterator *iter, void *context) {
     /* APP_LOG(APP_LOG_LEVEL_INFO, "weather code=%u", s_weather_code); */
   }
 
-  Tuple *settings_request_tuple = dict_find(iter, MESSAGE_KEY_SETTINGS_REQUEST);
-  if (settings_request_tuple) {
-    send_settings_to_phone();
-  }
-
   if (weather_settings_changed) {
-    update_weather_visibility();
+    top_bar_mark_dirty(TOP_BAR_WIDGET_WEATHER);
     update_weather_temp_text();
     update_weather_icon();
     if (weather_unit_changed) {
       s_last_weather = 0;
       s_weather_retry_count = 0;
     }
-    request_weather();
+  }
+
+  if (seconds_settings_changed) {
+    s_last_motion = time(NULL);
+  }
+  if (seconds_settings_changed || theme_changed) {
+    update_tick_subscription();
+  }
+
+  /* Settings changes are echoed as a hash only; the phone asks for the full
+   * set (or sends a mismatching hash) when it is out of date. */
+  Tuple *settings_request_tuple = dict_find(iter, MESSAGE_KEY_SETTINGS_REQUEST);
+  Tuple *settings_hash_tuple = dict_find(iter, MESSAGE_KEY_SETTINGS_HASH);
+  if (settings_request_tuple ||
+      (settings_hash_tuple && settings_hash_tuple->value->uint32 != settings_hash())) {
+    send_settings_to_phone(true);
+  } else if (settings_received) {
+    send_settings_to_phone(false);
   }
 }
 
@@ -658,37 +1089,26 @@ static void prv_window_load(Window *window) {
   s_line_layer = layer_create(GRect(0, line_y, bounds.size.w, 2));
   layer_set_update_proc(s_line_layer, line_layer_update_proc);
   layer_add_child(window_layer, s_line_layer);
-  s_corner_line_layer = layer_create(GRect(4, line_y / 2, 12, 2));
-  layer_set_update_proc(s_corner_line_layer, line_layer_update_proc);
-  layer_add_child(window_layer, s_corner_line_layer);
 #ifdef PBL_ROUND
   layer_set_hidden(s_line_layer, true);
-  layer_set_hidden(s_corner_line_layer, true);
 #endif
 
-  int icon_x = 4;
-  int icon_y = (line_y / 2) - (WEATHER_ICON_SIZE / 2);
-  s_weather_icon_layer = bitmap_layer_create(GRect(icon_x, icon_y,
-                                                   WEATHER_ICON_SIZE, WEATHER_ICON_SIZE));
-  bitmap_layer_set_background_color(s_weather_icon_layer, GColorClear);
-  layer_add_child(window_layer, bitmap_layer_get_layer(s_weather_icon_layer));
-
-  const int temp_x = icon_x + WEATHER_ICON_SIZE + 2;
-  int temp_y = icon_y;
-#ifndef PBL_ROUND
-  temp_y = icon_y - 1;
-#endif
-  s_weather_temp_layer = text_layer_create(GRect(temp_x, temp_y, 50, 16));
-  text_layer_set_background_color(s_weather_temp_layer, GColorClear);
-  text_layer_set_text_color(s_weather_temp_layer, GColorBlack);
-  text_layer_set_font(s_weather_temp_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD));
-  text_layer_set_text_alignment(s_weather_temp_layer, GTextAlignmentLeft);
-  layer_add_child(window_layer, text_layer_get_layer(s_weather_temp_layer));
+  for (int i = 0; i < TOP_BAR_WIDGET_COUNT; ++i) {
+    const TopBarWidget *widget = &s_top_bar_widgets[i];
+    s_top_bar_layers[i] = layer_create(top_bar_slot_frame(widget, bounds, line_y));
+    layer_set_update_proc(s_top_bar_layers[i], widget->draw);
+    layer_add_child(window_layer, s_top_bar_layers[i]);
+  }
 
   s_matrix_layer = layer_create(bounds);
   layer_set_update_proc(s_matrix_layer, matrix_layer_update_proc);
   layer_add_child(window_layer, s_matrix_layer);
 
+  s_seconds_layer = layer_create(seconds_layer_frame(bounds));
+  layer_set_update_proc(s_seconds_layer, seconds_layer_update_proc);
+  layer_set_hidden(s_seconds_layer, s_tick_units != SECOND_UNIT);
+  layer_add_child(window_layer, s_seconds_layer);
+
   s_time_layer = text_layer_create(GRect(0, time_y, bounds.size.w, time_height));
   text_layer_set_background_color(s_time_layer, GColorClear);
   text_layer_set_text_color(s_time_layer, GColorBlack);
@@ -698,18 +1118,7 @@ static void prv_window_load(Window *window) {
   text_layer_set_text_alignment(s_time_layer, GTextAlignmentCenter);
   layer_add_child(window_layer, text_layer_get_layer(s_time_layer));
 
-  const int battery_width = 26;
-  const int battery_height = 10;
-  const int battery_margin = (line_y - battery_height) / 2;
-  const int battery_x = bounds.size.w - battery_width - battery_margin;
-  const int battery_y = battery_margin;
-  s_battery_layer = layer_create(GRect(battery_x, battery_y, battery_width, battery_height));
-  layer_set_update_proc(s_battery_layer, battery_layer_update_proc);
-  layer_add_child(window_layer, s_battery_layer);
-
   apply_theme();
-  update_weather_visibility();
-  update_weather_layout();
   update_weather_temp_text();
   update_time();
 }
@@ -720,15 +1129,22 @@ static void prv_window_unload(Window *window) {
   fonts_unload_custom_font(s_date_font);
   fonts_unload_custom_font(s_time_font);
   layer_destroy(s_line_layer);
-  layer_destroy(s_corner_line_layer);
   layer_destroy(s_matrix_layer);
-  layer_destroy(s_battery_layer);
+  layer_destroy(s_seconds_layer);
+  s_seconds_layer = NULL;
+  for (int i = 0; i < TOP_BAR_WIDGET_COUNT; ++i) {
+    layer_destroy(s_top_bar_layers[i]);
+    s_top_bar_layers[i] = NULL;
+  }
   if (s_weather_icon_bitmap) {
     gbitmap_destroy(s_weather_icon_bitmap);
     s_weather_icon_bitmap = NULL;
+    s_weather_icon_index = 0;
+  }
+  if (s_weather_atlas_bitmap) {
+    gbitmap_destroy(s_weather_atlas_bitmap);
+    s_weather_atlas_bitmap = NULL;
   }
-  bitmap_layer_destroy(s_weather_icon_layer);
-  text_layer_destroy(s_weather_temp_layer);
 }
 
 static void prv_init(void) {
@@ -751,6 +1167,12 @@ static void prv_init(void) {
   if (persist_exists(PERSIST_KEY_WEATHER_CODE)) {
     s_weather_code = (uint8_t)persist_read_int(PERSIST_KEY_WEATHER_CODE);
   }
+  if (persist_exists(PERSIST_KEY_SECONDS_ENABLED)) {
+    s_seconds_enabled = persist_read_bool(PERSIST_KEY_SECONDS_ENABLED);
+  }
+  if (persist_exists(PERSIST_KEY_SECONDS_TIMEOUT)) {
+    s_seconds_timeout = (uint8_t)persist_read_int(PERSIST_KEY_SECONDS_TIMEOUT);
+  }
 
   s_window = window_create();
   window_set_window_handlers(s_window, (WindowHandlers) {
@@ -762,18 +1184,21 @@ static void prv_init(void) {
   window_stack_push(s_window, animated);
 
   app_message_register_inbox_received(inbox_received_handler);
-  app_message_open(64, 64);
+  app_message_open(128, 128);
   s_bt_connected = bluetooth_connection_service_peek();
   bluetooth_connection_service_subscribe(connection_handler);
-  send_settings_to_phone();
-  request_weather();
+  send_settings_to_phone(false);
 
-  tick_timer_service_subscribe(MINUTE_UNIT, tick_handler);
+  s_last_motion = time(NULL);
   battery_handler(battery_state_service_peek());
   battery_state_service_subscribe(battery_handler);
 }
 
 static void prv_deinit(void) {
+  if (s_accel_tap_subscribed) {
+    accel_tap_service_unsubscribe();
+  }
+  tick_timer_service_unsubscribe();
   battery_state_service_unsubscribe();
   bluetooth_connection_service_unsubscribe();
   window_destroy(s_window);
@@ -56,6 +56,34 @@ var clayConfig = [
       }
     ]
   },
+  {
+    type: 'section',
+    items: [
+      {
+        type: 'heading',
+        defaultValue: 'Seconds'
+      },
+      {
+        type: 'toggle',
+        messageKey: 'SECONDS_ENABLED',
+        label: 'Show seconds',
+        description: 'Falls back to minutes on low battery or when the wrist is still.',
+        defaultValue: false
+      },
+      {
+        type: 'select',
+        messageKey: 'SECONDS_TIMEOUT',
+        label: 'Hide seconds after no motion for',
+        defaultValue: 5,
+        options: [
+          { value: 1, label: '1 minute' },
+          { value: 5, label: '5 minutes' },
+          { value: 15, label: '15 minutes' },
+          { value: 30, label: '30 minutes' }
+        ]
+      }
+    ]
+  },
   {
     type: 'submit',
     defaultValue: 'Save'
@@ -64,8 +92,34 @@ var clayConfig = [
 
 var clay = new Clay(clayConfig);
 
+// Must match SETTINGS_HASH_VERSION and settings_hash() in HappyMac.c, and
+// phone_settings_hash() in sim/day.c.
+var SETTINGS_HASH_VERSION = 2;
+
+function settingsHash() {
+  var settings = {};
+  try {
+    settings = JSON.parse(localStorage.getItem('clay-settings')) || {};
+  } catch (e) {
+    settings = {};
+  }
+  var theme = parseInt(settings.theme, 10) || 0;
+  var enabled = typeof settings.WEATHER_ENABLED === 'undefined' || !!settings.WEATHER_ENABLED;
+  var showTemp = typeof settings.WEATHER_SHOW_TEMP === 'undefined' || !!settings.WEATHER_SHOW_TEMP;
+  var unit = settings.WEATHER_TEMP_UNIT === 'F' ? 1 : 0;
+  var seconds = !!settings.SECONDS_ENABLED;
+  var secondsTimeout = parseInt(settings.SECONDS_TIMEOUT, 10) || 5;
+  return (theme & 0xFF) |
+      ((enabled ? 1 : 0) << 8) |
+      ((showTemp ? 1 : 0) << 9) |
+      (unit << 10) |
+      ((seconds ? 1 : 0) << 11) |
+      (SETTINGS_HASH_VERSION << 16) |
+      ((secondsTimeout & 0x3F) << 24);
+}
+
 Pebble.addEventListener('showConfiguration', function() {
-  Pebble.sendAppMessage({ SETTINGS_REQUEST: 1 });
+  Pebble.sendAppMessage({ SETTINGS_HASH: settingsHash() });
 });
 
 function fetch(url, onResponse, onError) {
@@ -127,18 +181,37 @@ Pebble.addEventListener('appmessage', function(e) {
     return;
   }
   console.log('appmessage payload', JSON.stringify(e.payload));
+  var settings = {};
+  var hasSettings = false;
   if (typeof e.payload.theme !== 'undefined') {
-    clay.setSettings({ theme: e.payload.theme });
+    settings.theme = e.payload.theme;
+    hasSettings = true;
   }
   if (typeof e.payload.WEATHER_ENABLED !== 'undefined') {
-    clay.setSettings({ WEATHER_ENABLED: !!e.payload.WEATHER_ENABLED });
+    settings.WEATHER_ENABLED = !!e.payload.WEATHER_ENABLED;
+    hasSettings = true;
   }
   if (typeof e.payload.WEATHER_SHOW_TEMP !== 'undefined') {
-    clay.setSettings({ WEATHER_SHOW_TEMP: !!e.payload.WEATHER_SHOW_TEMP });
+    settings.WEATHER_SHOW_TEMP = !!e.payload.WEATHER_SHOW_TEMP;
+    hasSettings = true;
   }
   if (typeof e.payload.WEATHER_TEMP_UNIT !== 'undefined') {
-    var unit = e.payload.WEATHER_TEMP_UNIT === 1 ? 'F' : 'C';
-    clay.setSettings({ WEATHER_TEMP_UNIT: unit });
+    settings.WEATHER_TEMP_UNIT = e.payload.WEATHER_TEMP_UNIT === 1 ? 'F' : 'C';
+    hasSettings = true;
+  }
+  if (typeof e.payload.SECONDS_ENABLED !== 'undefined') {
+    settings.SECONDS_ENABLED = !!e.payload.SECONDS_ENABLED;
+    hasSettings = true;
+  }
+  if (typeof e.payload.SECONDS_TIMEOUT !== 'undefined') {
+    settings.SECONDS_TIMEOUT = e.payload.SECONDS_TIMEOUT;
+    hasSettings = true;
+  }
+  if (hasSettings) {
+    clay.setSettings(settings);
+  } else if (typeof e.payload.SETTINGS_HASH !== 'undefined' &&
+             e.payload.SETTINGS_HASH !== settingsHash()) {
+    Pebble.sendAppMessage({ SETTINGS_REQUEST: 1 });
   }
   if (typeof e.payload.WEATHER_REQUEST !== 'undefined') {
     weatherGet(e.payload.WEATHER_REQUEST);